@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""Compare two runs of run_benchmarks written by run_benchmarks.sh.
+
+For every benchmark present in both runs, the repetitions of the baseline
+and the contender are compared with a two-sided Mann-Whitney U test. A
+difference is significant if p < alpha, and a regression fails the check
+if the median time grows by more than the threshold.
+
+    ./compare_results.py results/host/abc1234/hip.json \\
+                         results/host/def5678/hip.json
+
+Exit status is 1 if any significant regression exceeds the threshold.
+Only the standard library is used.
+"""
+
+import argparse
+import json
+import math
+import statistics
+import sys
+from functools import lru_cache
+
+
+# Time units of google benchmark, in seconds
+TIME_UNITS = {'ns': 1e-9, 'us': 1e-6, 'ms': 1e-3, 's': 1.0}
+
+
+def load_repetitions(path, metric):
+    """Read the repetitions of every benchmark from a JSON file.
+
+    Returns a dict mapping run names, including arguments, to lists of
+    values. Times are converted to seconds; aggregates are skipped.
+    """
+    with open(path) as f:
+        results = json.load(f)
+
+    runs = {}
+    for bm in results['benchmarks']:
+        if bm.get('run_type', 'iteration') != 'iteration':
+            continue
+        if bm.get('error_occurred'):
+            continue
+
+        if metric in ('real_time', 'cpu_time'):
+            value = bm[metric] * TIME_UNITS[bm.get('time_unit', 'ns')]
+        elif metric in bm:
+            value = float(bm[metric])
+        else:
+            continue
+
+        runs.setdefault(bm.get('run_name', bm['name']), []).append(value)
+
+    return runs
+
+
+@lru_cache(maxsize=None)
+def _u_count(n1, n2, u):
+    """Number of orderings of n1 + n2 distinct items with statistic U = u."""
+    if u < 0 or u > n1 * n2:
+        return 0
+    if n1 == 0 or n2 == 0:
+        return 1 if u == 0 else 0
+    return _u_count(n1 - 1, n2, u - n2) + _u_count(n1, n2 - 1, u)
+
+
+def mann_whitney_u(x, y):
+    """Two-sided Mann-Whitney U test.
+
+    Returns (U of x, p-value). The p-value is exact for small samples
+    without ties, otherwise it comes from the normal approximation with
+    tie and continuity corrections.
+    """
+    n1, n2 = len(x), len(y)
+    n = n1 + n2
+
+    # Mid-ranks of the pooled samples
+    pooled = sorted([(v, 0) for v in x] + [(v, 1) for v in y])
+    ranks = [0.0] * n
+    ties = []
+    i = 0
+    while i < n:
+        j = i
+        while j + 1 < n and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1
+        ties.append(j - i + 1)
+        i = j + 1
+
+    r1 = sum(r for r, (_, group) in zip(ranks, pooled) if group == 0)
+    u1 = r1 - n1 * (n1 + 1) / 2.0
+    u = min(u1, n1 * n2 - u1)
+
+    if all(t == 1 for t in ties) and n1 * n2 <= 400:
+        total = math.comb(n, n1)
+        tail = sum(_u_count(n1, n2, k) for k in range(int(u) + 1))
+        return u1, min(1.0, 2.0 * tail / total)
+
+    tie_term = sum(t ** 3 - t for t in ties) / (n * (n - 1))
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - tie_term))
+    if sigma == 0:
+        return u1, 1.0
+
+    z = (abs(u1 - n1 * n2 / 2.0) - 0.5) / sigma
+    return u1, min(1.0, math.erfc(max(z, 0.0) / math.sqrt(2)))
+
+
+def compare(baseline, contender, alpha, threshold, higher_is_better):
+    """Compare runs present in both results.
+
+    Returns a list of (name, baseline median, contender median, change in
+    percent, p-value, verdict) and whether the check failed.
+    """
+    rows = []
+    failed = False
+
+    for name in sorted(set(baseline) & set(contender)):
+        x, y = baseline[name], contender[name]
+        if len(x) < 2 or len(y) < 2:
+            continue
+
+        median_x = statistics.median(x)
+        median_y = statistics.median(y)
+        change = (median_y / median_x - 1) * 100 if median_x else 0.0
+        _, p = mann_whitney_u(x, y)
+
+        worse = change < 0 if higher_is_better else change > 0
+        verdict = ''
+        if p < alpha:
+            verdict = 'regression' if worse else 'improvement'
+            if worse and abs(change) > threshold:
+                verdict = 'REGRESSION'
+                failed = True
+
+        rows.append((name, median_x, median_y, change, p, verdict))
+
+    return rows, failed
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compare two runs of run_benchmarks with a '
+                    'Mann-Whitney U test.')
+    parser.add_argument('baseline', help='JSON results of the baseline')
+    parser.add_argument('contender', help='JSON results to check')
+    parser.add_argument('--alpha', type=float, default=0.05,
+                        help='significance level (default: 0.05)')
+    parser.add_argument('--threshold', type=float, default=5.0,
+                        help='largest accepted regression of the median '
+                             'in percent (default: 5)')
+    parser.add_argument('--metric', default='real_time',
+                        help='real_time, cpu_time or a user counter '
+                             '(default: real_time)')
+    parser.add_argument('--higher-is-better', action='store_true',
+                        help='the metric is a rate, e.g. bytes_per_second')
+    args = parser.parse_args()
+
+    baseline = load_repetitions(args.baseline, args.metric)
+    contender = load_repetitions(args.contender, args.metric)
+
+    rows, failed = compare(baseline, contender, args.alpha, args.threshold,
+                           args.higher_is_better)
+    if not rows:
+        print('No benchmark with repetitions in both runs', file=sys.stderr)
+        return 2
+
+    width = max(len(row[0]) for row in rows)
+    print(f'{"Benchmark":<{width}}  {"Baseline":>12}  {"Contender":>12}'
+          f'  {"Change":>8}  {"p-value":>8}')
+    for name, median_x, median_y, change, p, verdict in rows:
+        print(f'{name:<{width}}  {median_x:>12.6g}  {median_y:>12.6g}'
+              f'  {change:>+7.2f}%  {p:>8.4f}  {verdict}')
+
+    missing = sorted(set(baseline) ^ set(contender))
+    if missing:
+        print(f'\n{len(missing)} benchmarks are only in one of the runs')
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,5 +1,12 @@
 #include <benchmark/benchmark.h>
-
+#include <cstring>
+#include <string>
+#include <memory>
+
+#include "utils/cold_start.h"   /* COLD_START */
+#include "utils/counters.h"     /* traffic counters */
+#include "utils/host_memory.h"  /* HostBuffer */
+#include "utils/timing.h"       /* IterationTimer */
 #include "copy.hip.h"
 
 
@@ -16,13 +23,13 @@ void bm_copy_h2d(benchmark::State &state) {
     thrust::host_vector<T>   host_X(N << 20, 0.5);
     thrust::device_vector<T> dev_X(N << 20);
 
+    benchutils::IterationTimer timer(state);
     for (auto _ : state) {
-        run_copy_h2d(host_X, dev_X);
-        hipDeviceSynchronize();
+        timer.time([&] { run_copy_h2d(host_X, dev_X); });
     }
 
-    state.SetBytesProcessed(int64_t(state.iterations())
-                            * int64_t(sizeof(T) * N << 20));
+    benchutils::setTrafficCounters(state, traffic_copy<T>(N << 20));
+    timer.setCounters();
 }
 
 
@@ -39,37 +46,100 @@ void bm_copy_d2h(benchmark::State &state) {
     thrust::device_vector<T> dev_X(N << 20, 0.5);
     thrust::host_vector<T>   host_X(N << 20);
 
+    benchutils::IterationTimer timer(state);
     for (auto _ : state) {
-        run_copy_d2h(dev_X, host_X);
-        hipDeviceSynchronize();
+        timer.time([&] { run_copy_d2h(dev_X, host_X); });
     }
 
-    state.SetBytesProcessed(int64_t(state.iterations())
-                            * int64_t(sizeof(T) * N << 20));
+    benchutils::setTrafficCounters(state, traffic_copy<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Copies between device memory and a kind of host memory
+///----------------------------------------------------------------------------
+void bm_copy_host_memory(benchmark::State &state) {
+
+    // Bytes per direction, kind of host memory and direction
+    size_t bytes = state.range(0);
+    auto kind    = gpuutils::HostMemory(state.range(1));
+    auto dir     = CopyDirection(state.range(2));
+
+    // Allocate host buffers of the kind and device buffers
+    gpuutils::HostBuffer host_in(bytes, kind);
+    gpuutils::HostBuffer host_out(bytes, kind);
+    thrust::device_vector<char> dev_in(bytes);
+    thrust::device_vector<char> dev_out(bytes, 1);
+
+    std::memset(host_in.data(), 1, bytes);
+    std::memset(host_out.data(), 0, bytes);
+
+    // Copies wait on host, and managed input is restored before each one
+    benchutils::IterationTimer timer(state, 1, /* events */ false);
+    for (auto _ : state) {
+        // Pages read on device migrate there, write them back on host
+        if (host_in.managed() && dir != CopyDirection::d2h)
+            std::memset(host_in.data(), 1, bytes);
+
+        timer.time([&] {
+            run_copy_host_memory(host_in, dev_in, dev_out, host_out, dir);
+        });
+    }
+
+    int n_directions = dir == CopyDirection::bidirectional ? 2 : 1;
+
+    benchutils::setTrafficCounters(state,
+                                   traffic_copy<char>(bytes * n_directions));
+    timer.setCounters();
+    state.SetLabel(std::string(gpuutils::hostMemoryName(kind)) + "/"
+                   + copy_direction_name(dir));
+}
+
+
+/// \brief Arguments (bytes, kind of host memory, direction), 4 KiB to 1 GiB
+void copy_host_memory_arguments(benchmark::internal::Benchmark *b) {
+    for (int dir = 0; dir < n_copy_directions; ++dir)
+        for (int kind = 0; kind < gpuutils::n_host_memory_kinds; ++kind)
+            for (int64_t bytes = 4 << 10; bytes <= 1 << 30; bytes *= 8)
+                b->Args({bytes, kind, dir});
 }
 
 
 /// Benchmark registration
 BENCHMARK_TEMPLATE(bm_copy_h2d, float)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(8)
     ->Range(2, 4000);
 
 BENCHMARK_TEMPLATE(bm_copy_h2d, double)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(8)
     ->Range(2, 2000);
 
 BENCHMARK_TEMPLATE(bm_copy_d2h, float)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(8)
     ->Range(2, 4000);
 
 BENCHMARK_TEMPLATE(bm_copy_d2h, double)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(8)
     ->Range(2, 2000);
+
+BENCHMARK(bm_copy_host_memory)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->Apply(copy_host_memory_arguments);
+
+
+/// Cold-start registration, first calls on 1M items
+COLD_START("run_copy_h2d<float>", [] {
+    auto host_X = std::make_shared<thrust::host_vector<float>>(1 << 20, 1.f);
+    auto dev_X  = std::make_shared<thrust::device_vector<float>>(1 << 20);
+    return [host_X, dev_X] { run_copy_h2d(*host_X, *dev_X); };
+});
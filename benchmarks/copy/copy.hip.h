@@ -4,6 +4,10 @@
 #include <thrust/host_vector.h>
 #include <thrust/device_vector.h>
 
+#include "utils/gpu_utils.h"     /* deviceSynchronize */
+#include "utils/host_memory.h"   /* HostBuffer, copyToDevice, copyToHost */
+#include "utils/traffic.h"       /* Traffic */
+
 
 /// \brief Memory copy from Host to Device
 template <typename T>
@@ -22,4 +26,63 @@ void run_copy_d2h(thrust::device_vector<T>& dev_X,
     thrust::copy(dev_X.begin(), dev_X.end(), host_X.begin());
 }
 
+/// \brief Traffic of a copy of n items between host and device, in either
+///        direction, each byte crossing the link once
+template <typename T>
+benchutils::Traffic traffic_copy(size_t n) {
+    return benchutils::Traffic::transfer(n, sizeof(T));
+}
+
+///----------------------------------------------------------------------------
+/// Kinds of host memory
+///----------------------------------------------------------------------------
+
+/// \brief Directions of copies between host buffers and the device
+enum class CopyDirection : int {
+    h2d = 0,            ///< Host to device
+    d2h,                ///< Device to host
+    bidirectional       ///< Both at once, on two streams
+};
+
+///< Number of copy directions
+constexpr int n_copy_directions = 3;
+
+
+/// \brief Get the name of a copy direction
+inline const char* copy_direction_name(CopyDirection dir) {
+    switch (dir) {
+        case CopyDirection::h2d:            return "h2d";
+        case CopyDirection::d2h:            return "d2h";
+        case CopyDirection::bidirectional:  return "bidirectional";
+    }
+    return "unknown";
+}
+
+
+/// \brief Copy host_in to dev_in and/or dev_out to host_out, and wait
+/// \details Pages of managed memory written on device without a prefetch
+///          are read back on host, so that every copy to host ends with
+///          the data on host.
+inline void run_copy_host_memory(gpuutils::HostBuffer &host_in,
+                                 thrust::device_vector<char> &dev_in,
+                                 thrust::device_vector<char> &dev_out,
+                                 gpuutils::HostBuffer &host_out,
+                                 CopyDirection dir) {
+
+    bool to_device = dir != CopyDirection::d2h;
+    bool to_host   = dir != CopyDirection::h2d;
+
+    if (to_device)
+        gpuutils::copyToDevice(host_in,
+                               thrust::raw_pointer_cast(dev_in.data()));
+    if (to_host)
+        gpuutils::copyToHost(thrust::raw_pointer_cast(dev_out.data()),
+                             host_out);
+
+    gpuutils::deviceSynchronize();
+
+    if (to_host && host_out.kind() == gpuutils::HostMemory::managed)
+        host_out.touch();
+}
+
 #endif  // BENCHMARK_COPY_H_
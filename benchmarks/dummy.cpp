@@ -1,3 +0,0 @@
-///
-/// A dummy source file
-///
@@ -0,0 +1,261 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+
+#include "utils/counters.h"     /* traffic counters */
+#include "utils/timing.h"       /* PhaseTimer */
+#include "file.hip.h"
+#include "norm/norm.hip.h"
+#include "sort/sort.hip.h"
+#include "sum/sum.hip.h"
+
+
+///< Items per pinned staging buffer, 16 MiB
+template <typename T>
+constexpr size_t staging_items = (size_t(16) << 20) / sizeof(T);
+
+
+/// \brief Time mapping, staging and computing on a column file
+/// \details Phases are timed apart: fault maps the file and reads a byte
+///          per page, staging copies the column to device through pinned
+///          buffers, compute runs on the device vector. A cold run drops
+///          the file from the page cache before each iteration. Bytes
+///          processed are the bytes of the file, end to end; transfer is
+///          the rate of staging, and device counters are over compute.
+/// \param compute A function running on the device vector
+/// \param traffic Traffic of compute for n items
+template <typename T, typename F>
+void time_file_phases(benchmark::State &state, F compute,
+                      benchutils::Traffic (*traffic)(size_t)) {
+
+    // Number of items (million) and whether the page cache is cold
+    size_t N  = state.range(0);
+    bool cold = state.range(1) != 0;
+
+    auto path = column_file<T>(N << 20);
+
+    gpuutils::StagingPool<T> pool(staging_items<T>, 3);
+    thrust::device_vector<T> X(N << 20);
+    std::unique_ptr<benchutils::MappedFile> file;
+
+    benchutils::PhaseTimer timer(state);
+    for (auto _ : state) {
+        if (cold)
+            benchutils::MappedFile::evict(path);
+
+        timer.time("fault", [&] {
+            file.reset(new benchutils::MappedFile(path));
+            file->touch();
+        });
+        timer.time("staging", [&] { run_stage_column(pool, *file, X); });
+        timer.time("compute", [&] { compute(X); });
+        timer.endIteration();
+
+        file.reset();
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * (N << 20)
+                                    * sizeof(T)));
+    benchutils::setTrafficCounters(
+        state, benchutils::Traffic::transfer(N << 20, sizeof(T)),
+        timer.phaseTime("staging"));
+    benchutils::setTrafficCounters(state, traffic(N << 20),
+                                   timer.phaseTime("compute"));
+    timer.setCounters();
+    state.SetLabel(cold ? "cold" : "warm");
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::reduce of a column file, staged to device
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_file_sum(benchmark::State &state) {
+
+    time_file_phases<T>(state, [](thrust::device_vector<T> &X) {
+        benchmark::DoNotOptimize(run_sum(X));
+    }, traffic_sum<T>);
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::transform_reduce norm of a column file, staged to device
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_file_norm(benchmark::State &state) {
+
+    time_file_phases<T>(state, [](thrust::device_vector<T> &X) {
+        benchmark::DoNotOptimize(run_norm(X));
+    }, traffic_norm<T>);
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::sort of a column file, staged to device
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_file_sort(benchmark::State &state) {
+
+    time_file_phases<T>(state, [](thrust::device_vector<T> &X) {
+        run_sort(X);
+    }, traffic_sort<T>);
+}
+
+
+/// \brief Time mapping and computing on a column file with the host system
+/// \details As time_file_phases, without staging: compute reads the mapped
+///          file in place. Under HIP there is no peak% since the peak is
+///          the device's.
+/// \param compute A function running on the mapped file
+/// \param traffic Traffic of compute for n items
+template <typename T, typename F>
+void time_file_phases_host(benchmark::State &state, F compute,
+                           benchutils::Traffic (*traffic)(size_t)) {
+
+    // Number of items (million) and whether the page cache is cold
+    size_t N  = state.range(0);
+    bool cold = state.range(1) != 0;
+
+    auto path = column_file<T>(N << 20);
+    std::unique_ptr<benchutils::MappedFile> file;
+
+    benchutils::PhaseTimer timer(state);
+    for (auto _ : state) {
+        if (cold)
+            benchutils::MappedFile::evict(path);
+
+        timer.time("fault", [&] {
+            file.reset(new benchutils::MappedFile(path));
+            file->touch();
+        });
+        timer.time("compute", [&] { compute(*file); });
+        timer.endIteration();
+
+        file.reset();
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * (N << 20)
+                                    * sizeof(T)));
+    benchutils::setTrafficCounters(state, traffic(N << 20),
+                                   timer.phaseTime("compute"));
+#ifdef USE_HIP
+    state.counters.erase("peak%");
+#endif
+    timer.setCounters();
+    state.SetLabel(cold ? "cold" : "warm");
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::reduce of a column file with the host system, in place
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_file_sum_host(benchmark::State &state) {
+
+    time_file_phases_host<T>(state, [](const benchutils::MappedFile &file) {
+        benchmark::DoNotOptimize(run_sum_host<T>(file));
+    }, traffic_sum<T>);
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::transform_reduce norm of a column file with the host system
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_file_norm_host(benchmark::State &state) {
+
+    time_file_phases_host<T>(state, [](const benchutils::MappedFile &file) {
+        benchmark::DoNotOptimize(run_norm_host<T>(file));
+    }, traffic_norm<T>);
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::sort of a column file into a host vector with the host system
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_file_sort_host(benchmark::State &state) {
+
+    thrust::host_vector<T> Y(size_t(state.range(0)) << 20);
+
+    time_file_phases_host<T>(state, [&](const benchutils::MappedFile &file) {
+        run_sort_host(file, Y);
+    }, traffic_sort_host<T>);
+}
+
+
+///----------------------------------------------------------------------------
+/// Streaming reduction of a column file, faults overlapped with copies
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_file_sum_streaming(benchmark::State &state) {
+
+    // Number of items (million) and whether the page cache is cold
+    size_t N  = state.range(0);
+    bool cold = state.range(1) != 0;
+
+    auto path = column_file<T>(N << 20);
+    gpuutils::StreamingReducer<T> reducer(staging_items<T>, 3);
+
+    benchutils::PhaseTimer timer(state);
+    for (auto _ : state) {
+        if (cold)
+            benchutils::MappedFile::evict(path);
+
+        timer.time("pipeline", [&] {
+            benchutils::MappedFile file(path);
+            benchmark::DoNotOptimize(reducer.transformReduce(
+                file.begin<T>(), file.end<T>(), thrust::identity<T>(),
+                T(0), thrust::plus<T>()));
+        });
+        timer.endIteration();
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sum_streaming<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel(cold ? "cold" : "warm");
+}
+
+
+/// \brief Arguments (million items, cold page cache) for column files
+void file_arguments(benchmark::internal::Benchmark *b) {
+    for (int cold = 0; cold <= 1; ++cold)
+        for (int N = 64; N <= 1024; N *= 4)
+            b->Args({N, cold});
+}
+
+
+/// Benchmark registration
+BENCHMARK_TEMPLATE(bm_file_sum, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(file_arguments);
+
+BENCHMARK_TEMPLATE(bm_file_norm, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(file_arguments);
+
+BENCHMARK_TEMPLATE(bm_file_sort, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(file_arguments);
+
+BENCHMARK_TEMPLATE(bm_file_sum_host, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(file_arguments);
+
+BENCHMARK_TEMPLATE(bm_file_norm_host, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(file_arguments);
+
+BENCHMARK_TEMPLATE(bm_file_sort_host, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(file_arguments);
+
+BENCHMARK_TEMPLATE(bm_file_sum_streaming, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(file_arguments);
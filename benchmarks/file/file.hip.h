@@ -0,0 +1,77 @@
+#ifndef BENCHMARK_FILE_H_
+#define BENCHMARK_FILE_H_
+
+#include <thrust/copy.h>
+#include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
+#include <thrust/functional.h>
+#include <thrust/host_vector.h>
+#include <thrust/reduce.h>
+#include <thrust/sort.h>
+#include <thrust/transform_reduce.h>
+#include <cmath>
+#include <string>
+
+#include "norm/norm.hip.h"       /* square */
+#include "sort/sort.hip.h"       /* traffic_sort */
+
+#include "utils/generators.h"    /* dataFile */
+#include "utils/mapped_file.h"   /* MappedFile */
+#include "utils/streaming.h"     /* StagingPool */
+#include "utils/traffic.h"       /* Traffic */
+
+
+/// \brief Get a column file of n uniform items, written if missing
+/// \return Path of the file in options().data_dir
+template <typename T>
+std::string column_file(size_t n) {
+    return benchutils::dataFile<T>(benchutils::DataSpec(), n);
+}
+
+
+/// \brief Copy a mapped column to device through pinned staging buffers
+template <typename T>
+void run_stage_column(gpuutils::StagingPool<T> &pool,
+                      const benchutils::MappedFile &file,
+                      thrust::device_vector<T> &X) {
+    pool.copy(file.begin<T>(), file.end<T>(), X);
+}
+
+
+/// \brief Sum up a mapped column with the host system, in place
+template <typename T>
+T run_sum_host(const benchutils::MappedFile &file) {
+    return thrust::reduce(thrust::host, file.begin<T>(), file.end<T>(),
+                          T(0), thrust::plus<T>());
+}
+
+
+/// \brief Compute sqrt(x*x) of a mapped column with the host system, in
+///        place
+template <typename T>
+T run_norm_host(const benchutils::MappedFile &file) {
+    return std::sqrt(thrust::transform_reduce(thrust::host,
+                                              file.begin<T>(), file.end<T>(),
+                                              square<T>(), T(0),
+                                              thrust::plus<T>()));
+}
+
+
+/// \brief Sort a mapped column into a host vector with the host system
+/// \param Y Host vector of as many items as the column
+template <typename T>
+void run_sort_host(const benchutils::MappedFile &file,
+                   thrust::host_vector<T> &Y) {
+    thrust::copy(thrust::host, file.begin<T>(), file.end<T>(), Y.begin());
+    thrust::sort(thrust::host, Y.begin(), Y.end());
+}
+
+
+/// \brief Traffic of run_sort_host, copy the column and sort it
+template <typename T>
+benchutils::Traffic traffic_sort_host(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 1)
+         + traffic_sort<T>(n);
+}
+
+#endif  // BENCHMARK_FILE_H_
@@ -0,0 +1,324 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+
+#include "utils/cold_start.h"   /* COLD_START */
+#include "utils/counters.h"     /* allocator and traffic counters */
+#include "utils/timing.h"       /* IterationTimer */
+#include "layout.hip.h"
+
+
+///----------------------------------------------------------------------------
+/// Y = A * X + Y over records as an array of structs
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_layout_saxpy_aos(benchmark::State &state) {
+
+    // Number of records (million)
+    size_t N = state.range(0);
+
+    // Define scalar A and allocate records
+    T A = 2.0;
+    aos_records<T> R(N << 20, uniform_record(T(1)));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_saxpy_aos(A, R); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_saxpy_aos<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel("aos");
+}
+
+
+///----------------------------------------------------------------------------
+/// Y = A * X + Y over records as a struct of arrays
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_layout_saxpy_soa(benchmark::State &state) {
+
+    // Number of records (million)
+    size_t N = state.range(0);
+
+    // Define scalar A and allocate records
+    T A = 2.0;
+    soa_records<T> R(N << 20);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_saxpy_soa(A, R); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_saxpy_soa<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel("soa");
+}
+
+
+///----------------------------------------------------------------------------
+/// Y = A * X + Y over records as AoSoA tiles
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_layout_saxpy_aosoa(benchmark::State &state) {
+
+    // Number of records (million)
+    size_t N = state.range(0);
+
+    // Define scalar A and allocate records
+    T A = 2.0;
+    aosoa_records<T> R(N << 20);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_saxpy_aosoa(A, R); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_saxpy_soa<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel("aosoa");
+}
+
+
+///----------------------------------------------------------------------------
+/// Norm of positions of records as an array of structs
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_layout_norm_aos(benchmark::State &state) {
+
+    // Number of records (million)
+    size_t N = state.range(0);
+
+    // Allocate records
+    aos_records<T> R(N << 20, uniform_record(T(1)));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_norm_aos(R)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_norm_aos<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel("aos");
+}
+
+
+///----------------------------------------------------------------------------
+/// Norm of positions of records as a struct of arrays
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_layout_norm_soa(benchmark::State &state) {
+
+    // Number of records (million)
+    size_t N = state.range(0);
+
+    // Allocate records
+    soa_records<T> R(N << 20);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_norm_soa(R)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_norm_soa<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel("soa");
+}
+
+
+///----------------------------------------------------------------------------
+/// Norm of positions of records as AoSoA tiles
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_layout_norm_aosoa(benchmark::State &state) {
+
+    // Number of records (million)
+    size_t N = state.range(0);
+
+    // Allocate records
+    aosoa_records<T> R(N << 20);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_norm_aosoa(R)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_norm_soa<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel("aosoa");
+}
+
+
+///----------------------------------------------------------------------------
+/// Y[i] = X[I[i]] for a pattern of indices
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_gather(benchmark::State &state) {
+
+    // Number of items (million) and index pattern
+    size_t N     = state.range(0);
+    auto pattern = IndexPattern(state.range(1));
+
+    // Allocate vectors and make the indices
+    thrust::device_vector<T> X(N << 20, T(1));
+    thrust::device_vector<T> Y(N << 20);
+    auto I = make_indices(N << 20, pattern);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_gather(I, X, Y); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_gather<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel(index_pattern_name(pattern));
+}
+
+
+///----------------------------------------------------------------------------
+/// Y[I[i]] = X[i] for a pattern of indices
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_scatter(benchmark::State &state) {
+
+    // Number of items (million) and index pattern
+    size_t N     = state.range(0);
+    auto pattern = IndexPattern(state.range(1));
+
+    // Allocate vectors and make the indices
+    thrust::device_vector<T> X(N << 20, T(1));
+    thrust::device_vector<T> Y(N << 20);
+    auto I = make_indices(N << 20, pattern);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_scatter(I, X, Y); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_gather<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel(index_pattern_name(pattern));
+}
+
+
+///----------------------------------------------------------------------------
+/// AoS to SoA conversion, one pass
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_aos_to_soa(benchmark::State &state) {
+
+    // Number of records (million)
+    size_t N = state.range(0);
+
+    // Allocate records in both layouts
+    aos_records<T> R(N << 20, uniform_record(T(1)));
+    soa_records<T> S(N << 20);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_aos_to_soa(R, S); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_aos_to_soa<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// AoS to SoA conversion, one pass per field
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_aos_to_soa_by_field(benchmark::State &state) {
+
+    // Number of records (million)
+    size_t N = state.range(0);
+
+    // Allocate records in both layouts
+    aos_records<T> R(N << 20, uniform_record(T(1)));
+    soa_records<T> S(N << 20);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_aos_to_soa_by_field(R, S); });
+    }
+
+    benchutils::setTrafficCounters(state,
+                                   traffic_aos_to_soa_by_field<T>(N << 20));
+    timer.setCounters();
+}
+
+
+/// \brief Arguments (million items, index pattern) for gathers and scatters
+void index_pattern_arguments(benchmark::internal::Benchmark *b) {
+    for (int pattern = 0; pattern < n_index_patterns; ++pattern)
+        for (int N = 4; N <= 64; N *= 4)
+            b->Args({N, pattern});
+}
+
+
+/// Benchmark registration
+BENCHMARK_TEMPLATE(bm_layout_saxpy_aos, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+BENCHMARK_TEMPLATE(bm_layout_saxpy_soa, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+BENCHMARK_TEMPLATE(bm_layout_saxpy_aosoa, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+BENCHMARK_TEMPLATE(bm_layout_norm_aos, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+BENCHMARK_TEMPLATE(bm_layout_norm_soa, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+BENCHMARK_TEMPLATE(bm_layout_norm_aosoa, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+BENCHMARK_TEMPLATE(bm_gather, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(index_pattern_arguments);
+
+BENCHMARK_TEMPLATE(bm_scatter, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(index_pattern_arguments);
+
+BENCHMARK_TEMPLATE(bm_aos_to_soa, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+BENCHMARK_TEMPLATE(bm_aos_to_soa_by_field, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+
+/// Cold-start registration, first calls on 1M records
+COLD_START("run_aos_to_soa<float>", [] {
+    auto R = std::make_shared<aos_records<float>>(1 << 20,
+                                                  uniform_record(1.f));
+    auto S = std::make_shared<soa_records<float>>(1 << 20);
+    return [R, S] { run_aos_to_soa(*R, *S); };
+});
@@ -0,0 +1,487 @@
+#ifndef BENCHMARK_LAYOUT_H_
+#define BENCHMARK_LAYOUT_H_
+
+#include <thrust/copy.h>
+#include <thrust/device_vector.h>
+#include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "utils/allocators.h"    /* policy */
+#include "utils/generators.h"    /* generate */
+#include "utils/traffic.h"       /* Traffic */
+
+
+///----------------------------------------------------------------------------
+/// Layouts of records
+///----------------------------------------------------------------------------
+
+///< Number of fields of a record
+constexpr int n_fields = 8;
+
+///< Records per tile of the AoSoA layout
+constexpr int tile_width = 32;
+
+
+/// \brief A particle, of which computations touch two or three fields
+template <typename T>
+struct record {
+    T x, y, z;
+    T vx, vy, vz;
+    T mass, charge;
+};
+
+
+/// \brief Get a record with every field set to a value
+template <typename T>
+record<T> uniform_record(T value) {
+    return record<T>{value, value, value, value, value, value, value, value};
+}
+
+
+/// \brief Records as an array of structs
+template <typename T>
+using aos_records = thrust::device_vector<record<T>>;
+
+
+/// \brief Records as a struct of arrays, one device vector per field
+template <typename T>
+struct soa_records {
+
+    std::vector<thrust::device_vector<T>> fields;
+
+    explicit soa_records(size_t n, T value = T(1))
+        : fields(n_fields, thrust::device_vector<T>(n, value)) {}
+
+    size_t size() const { return fields[0].size(); }
+};
+
+
+/// \brief Records as an array of tiles of tile_width records
+/// \details A tile stores each field of its records contiguously, so that
+///          a field is read in whole cache lines, and the fields of a
+///          record stay within one tile.
+template <typename T>
+struct aosoa_records {
+
+    thrust::device_vector<T> data;
+    size_t n;
+
+    explicit aosoa_records(size_t n, T value = T(1))
+        : data((n + tile_width - 1) / tile_width * tile_width * n_fields,
+               value),
+          n(n) {}
+
+    size_t size() const { return n; }
+};
+
+
+/// \brief A functor for the offset of field k of record i in AoSoA tiles
+struct aosoa_offset {
+
+    int field;
+
+    __host__ __device__
+    size_t operator()(size_t i) const {
+        return (i / tile_width) * (tile_width * n_fields)
+             + size_t(field) * tile_width + i % tile_width;
+    }
+};
+
+
+///< Iterator over a field of AoSoA records
+template <typename T>
+using aosoa_iterator = thrust::permutation_iterator<
+    typename thrust::device_vector<T>::iterator,
+    thrust::transform_iterator<aosoa_offset,
+                               thrust::counting_iterator<size_t>>>;
+
+
+/// \brief Get an iterator over a field of AoSoA records
+template <typename T>
+aosoa_iterator<T> aosoa_field(aosoa_records<T> &R, int field) {
+    auto offsets = thrust::make_transform_iterator(
+                       thrust::make_counting_iterator<size_t>(0),
+                       aosoa_offset{field});
+    return thrust::make_permutation_iterator(R.data.begin(), offsets);
+}
+
+
+///----------------------------------------------------------------------------
+/// Y = A * X + Y over the x and y fields
+///----------------------------------------------------------------------------
+
+/// \brief A functor for A * x + y
+template <typename T>
+struct saxpy_op {
+
+    T a;
+
+    __host__ __device__
+    T operator()(const T &x, const T &y) const {
+        return a * x + y;
+    }
+};
+
+
+/// \brief A functor for y = A * x + y on a record
+template <typename T>
+struct saxpy_record {
+
+    T a;
+
+    __host__ __device__
+    void operator()(record<T> &r) const {
+        r.y = a * r.x + r.y;
+    }
+};
+
+
+/// \brief SAXPY over fields of an array of structs
+template <typename T>
+void run_saxpy_aos(T A, aos_records<T> &R) {
+    thrust::for_each(gpuutils::policy(), R.begin(), R.end(),
+                     saxpy_record<T>{A});
+}
+
+
+/// \brief Traffic of run_saxpy_aos, whole records read, y written
+/// \details Fields share cache lines, so that reading two of them brings
+///          in the whole record.
+template <typename T>
+benchutils::Traffic traffic_saxpy_aos(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(record<T>), 1, 0)
+         + benchutils::Traffic::items(n, sizeof(T), 0, 1, 2);
+}
+
+
+/// \brief SAXPY over fields of a struct of arrays
+template <typename T>
+void run_saxpy_soa(T A, soa_records<T> &R) {
+    auto &X = R.fields[0];
+    auto &Y = R.fields[1];
+    thrust::transform(gpuutils::policy(),
+                      X.begin(), X.end(), Y.begin(), Y.begin(),
+                      saxpy_op<T>{A});
+}
+
+
+/// \brief SAXPY over fields of AoSoA tiles
+template <typename T>
+void run_saxpy_aosoa(T A, aosoa_records<T> &R) {
+    auto X = aosoa_field(R, 0);
+    auto Y = aosoa_field(R, 1);
+    thrust::transform(gpuutils::policy(),
+                      X, X + R.size(), Y, Y, saxpy_op<T>{A});
+}
+
+
+/// \brief Traffic of run_saxpy_soa and run_saxpy_aosoa, read x and y,
+///        write y
+template <typename T>
+benchutils::Traffic traffic_saxpy_soa(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 2, 1, 2);
+}
+
+
+///----------------------------------------------------------------------------
+/// sqrt(sum of x*x + y*y + z*z) over the position fields
+///----------------------------------------------------------------------------
+
+/// \brief A functor for the squared length of a position tuple (x, y, z)
+template <typename T>
+struct squared_length {
+
+    template <typename Tuple>
+    __host__ __device__
+    T operator()(const Tuple &p) const {
+        T x = thrust::get<0>(p), y = thrust::get<1>(p), z = thrust::get<2>(p);
+        return x * x + y * y + z * z;
+    }
+};
+
+
+/// \brief A functor for the squared length of the position of a record
+template <typename T>
+struct squared_length_record {
+
+    __host__ __device__
+    T operator()(const record<T> &r) const {
+        return r.x * r.x + r.y * r.y + r.z * r.z;
+    }
+};
+
+
+/// \brief Norm of the positions of an array of structs
+template <typename T>
+T run_norm_aos(aos_records<T> &R) {
+    return std::sqrt(thrust::transform_reduce(gpuutils::policy(),
+                                              R.begin(), R.end(),
+                                              squared_length_record<T>(),
+                                              T(0), thrust::plus<T>()));
+}
+
+
+/// \brief Traffic of run_norm_aos, whole records read, 6 FLOPs per record
+template <typename T>
+benchutils::Traffic traffic_norm_aos(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(record<T>), 1, 0, 6);
+}
+
+
+/// \brief Norm of the positions of a struct of arrays
+template <typename T>
+T run_norm_soa(soa_records<T> &R) {
+    auto &f = R.fields;
+    auto P  = thrust::make_zip_iterator(thrust::make_tuple(
+                  f[0].begin(), f[1].begin(), f[2].begin()));
+    return std::sqrt(thrust::transform_reduce(gpuutils::policy(),
+                                              P, P + R.size(),
+                                              squared_length<T>(),
+                                              T(0), thrust::plus<T>()));
+}
+
+
+/// \brief Norm of the positions of AoSoA tiles
+template <typename T>
+T run_norm_aosoa(aosoa_records<T> &R) {
+    auto P = thrust::make_zip_iterator(thrust::make_tuple(
+                 aosoa_field(R, 0), aosoa_field(R, 1), aosoa_field(R, 2)));
+    return std::sqrt(thrust::transform_reduce(gpuutils::policy(),
+                                              P, P + R.size(),
+                                              squared_length<T>(),
+                                              T(0), thrust::plus<T>()));
+}
+
+
+/// \brief Traffic of run_norm_soa and run_norm_aosoa, read x, y and z
+template <typename T>
+benchutils::Traffic traffic_norm_soa(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 3, 0, 6);
+}
+
+
+///----------------------------------------------------------------------------
+/// AoS to SoA conversion
+///----------------------------------------------------------------------------
+
+/// \brief A functor for the fields of a record as a tuple
+template <typename T>
+struct record_fields {
+
+    __host__ __device__
+    thrust::tuple<T, T, T, T, T, T, T, T>
+    operator()(const record<T> &r) const {
+        return thrust::make_tuple(r.x, r.y, r.z, r.vx, r.vy, r.vz,
+                                  r.mass, r.charge);
+    }
+};
+
+
+/// \brief A functor for a field of a record
+template <typename T>
+struct record_field {
+
+    int field;
+
+    __host__ __device__
+    T operator()(const record<T> &r) const {
+        switch (field) {
+            case 0:  return r.x;
+            case 1:  return r.y;
+            case 2:  return r.z;
+            case 3:  return r.vx;
+            case 4:  return r.vy;
+            case 5:  return r.vz;
+            case 6:  return r.mass;
+            default: return r.charge;
+        }
+    }
+};
+
+
+/// \brief Convert records to a struct of arrays in a single pass
+/// \details Each record is read once and its fields written through a zip
+///          iterator over all arrays.
+template <typename T>
+void run_aos_to_soa(aos_records<T> &R, soa_records<T> &S) {
+    auto &f = S.fields;
+    auto out = thrust::make_zip_iterator(thrust::make_tuple(
+                   f[0].begin(), f[1].begin(), f[2].begin(), f[3].begin(),
+                   f[4].begin(), f[5].begin(), f[6].begin(), f[7].begin()));
+    thrust::transform(gpuutils::policy(), R.begin(), R.end(), out,
+                      record_fields<T>());
+}
+
+
+/// \brief Traffic of run_aos_to_soa, read and write every record once
+template <typename T>
+benchutils::Traffic traffic_aos_to_soa(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(record<T>), 1, 1);
+}
+
+
+/// \brief Convert records to a struct of arrays, one pass per field
+template <typename T>
+void run_aos_to_soa_by_field(aos_records<T> &R, soa_records<T> &S) {
+    for (int k = 0; k < n_fields; ++k)
+        thrust::transform(gpuutils::policy(), R.begin(), R.end(),
+                          S.fields[k].begin(), record_field<T>{k});
+}
+
+
+/// \brief Traffic of run_aos_to_soa_by_field, whole records read per field
+template <typename T>
+benchutils::Traffic traffic_aos_to_soa_by_field(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(record<T>), n_fields, 0)
+         + benchutils::Traffic::items(n, sizeof(T), 0, n_fields);
+}
+
+
+///----------------------------------------------------------------------------
+/// Gather and scatter
+///----------------------------------------------------------------------------
+
+///< Type of gather and scatter indices
+using layout_index = int32_t;
+
+
+/// \brief Patterns of gather and scatter indices
+enum class IndexPattern : int {
+    sequential = 0,     ///< i
+    strided,            ///< A transpose, consecutive indices 1024 apart
+    blocked,            ///< Random order of blocks of 256 indices
+    random              ///< A random permutation
+};
+
+///< Number of index patterns
+constexpr int n_index_patterns = 4;
+
+///< Stride of IndexPattern::strided, block of IndexPattern::blocked
+constexpr size_t index_stride = 1024;
+constexpr size_t index_block  = 256;
+
+
+/// \brief Get the name of an index pattern
+inline const char* index_pattern_name(IndexPattern pattern) {
+    switch (pattern) {
+        case IndexPattern::sequential:  return "sequential";
+        case IndexPattern::strided:     return "strided";
+        case IndexPattern::blocked:     return "blocked";
+        case IndexPattern::random:      return "random";
+    }
+    return "unknown";
+}
+
+
+/// \brief A functor for the i-th index of a transpose of n / stride rows
+struct strided_index {
+
+    size_t rows;
+
+    __host__ __device__
+    layout_index operator()(size_t i) const {
+        return layout_index((i % rows) * index_stride + i / rows);
+    }
+};
+
+
+/// \brief A functor for the i-th index of a permutation of blocks
+struct blocked_index {
+
+    const layout_index *blocks;
+
+    __host__ __device__
+    layout_index operator()(size_t i) const {
+        return layout_index(blocks[i / index_block] * index_block
+                            + i % index_block);
+    }
+};
+
+
+/// \brief Fill a vector with a random permutation of [0, size)
+/// \details Indices are sorted by random keys.
+inline void random_permutation(thrust::device_vector<layout_index> &P,
+                               uint64_t seed = 42) {
+    thrust::device_vector<uint64_t> keys(P.size());
+    benchutils::generate(keys, benchutils::DataSpec(
+                                   benchutils::Distribution::uniform, seed));
+    thrust::sequence(P.begin(), P.end());
+    thrust::sort_by_key(keys.begin(), keys.end(), P.begin());
+}
+
+
+/// \brief Make n indices of a pattern, a permutation of [0, n)
+inline thrust::device_vector<layout_index>
+make_indices(size_t n, IndexPattern pattern) {
+
+    if (n % index_stride != 0)
+        throw std::invalid_argument("Index patterns need a multiple of "
+                                    "1024 items");
+
+    thrust::device_vector<layout_index> I(n);
+    auto i = thrust::make_counting_iterator<size_t>(0);
+
+    switch (pattern) {
+        case IndexPattern::strided:
+            thrust::transform(i, i + n, I.begin(),
+                              strided_index{n / index_stride});
+            break;
+        case IndexPattern::blocked: {
+            thrust::device_vector<layout_index> blocks(n / index_block);
+            random_permutation(blocks);
+            thrust::transform(i, i + n, I.begin(), blocked_index{
+                thrust::raw_pointer_cast(blocks.data())});
+            break;
+        }
+        case IndexPattern::random:
+            random_permutation(I);
+            break;
+        default:
+            thrust::sequence(I.begin(), I.end());
+    }
+
+    return I;
+}
+
+
+/// \brief Y[i] = X[I[i]] through a permutation_iterator
+template <typename T>
+void run_gather(thrust::device_vector<layout_index> &I,
+                thrust::device_vector<T> &X, thrust::device_vector<T> &Y) {
+    auto src = thrust::make_permutation_iterator(X.begin(), I.begin());
+    thrust::copy(gpuutils::policy(), src, src + I.size(), Y.begin());
+}
+
+
+/// \brief Y[I[i]] = X[i] through a permutation_iterator
+template <typename T>
+void run_scatter(thrust::device_vector<layout_index> &I,
+                 thrust::device_vector<T> &X, thrust::device_vector<T> &Y) {
+    auto dst = thrust::make_permutation_iterator(Y.begin(), I.begin());
+    thrust::copy(gpuutils::policy(), X.begin(), X.end(), dst);
+}
+
+
+/// \brief Traffic of run_gather and run_scatter, read indices and X,
+///        write Y, as if every item moved alone
+template <typename T>
+benchutils::Traffic traffic_gather(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(layout_index), 1, 0)
+         + benchutils::Traffic::items(n, sizeof(T), 1, 1);
+}
+
+
+#endif  // BENCHMARK_LAYOUT_H_
@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "utils/cold_start.h"   /* runColdStart, runColdStartSample */
+#include "utils/counters.h"     /* setMemoryBaseline */
+#include "utils/gpu_utils.h"    /* startWarmUp, waitWarmUp */
+#include "utils/latency.h"      /* LatencyDumpReporter */
+#include "utils/options.h"      /* parseOptions */
+
+
+int main(int argc, char **argv) {
+
+    // Suite options go first, the rest is for google benchmark
+    try {
+        benchutils::parseOptions(&argc, argv);
+    }
+    catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s: error: %s\n", argv[0], e.what());
+        return 1;
+    }
+
+    const auto &options = benchutils::options();
+
+    // The driver does not touch the device, samples run in new processes
+    if (options.cold_start > 0 && options.cold_start_sample.empty())
+        return benchutils::runColdStart(argv[0]);
+
+    // Warm up first thing, as a service would
+    if (options.eager_init)
+        gpuutils::startWarmUp();
+
+    if (!options.cold_start_sample.empty())
+        return benchutils::runColdStartSample();
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--help") == 0)
+            benchutils::printUsage();
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    // Memory in use before any input is allocated
+    gpuutils::waitWarmUp();
+    benchutils::setMemoryBaseline();
+
+    // Raw latencies are written once the runs of a benchmark are reported
+    std::unique_ptr<benchutils::LatencyDumpReporter> reporter;
+    try {
+        if (!options.latency_dump.empty())
+            reporter.reset(
+                new benchutils::LatencyDumpReporter(options.latency_dump));
+    }
+    catch (const std::runtime_error &e) {
+        std::fprintf(stderr, "%s: error: %s\n", argv[0], e.what());
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks(reporter.get());
+
+    return 0;
+}
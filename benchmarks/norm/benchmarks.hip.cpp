@@ -1,6 +1,16 @@
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <vector>
+#include <memory>
 
+#include "utils/segments.h"     /* make_offsets, random_lengths */
+#include "utils/cold_start.h"   /* COLD_START */
+#include "utils/counters.h"     /* traffic counters */
+#include "utils/host_memory.h"  /* HostBuffer, HostMemory */
+#include "utils/inputs.h"       /* InputKind, withInput */
+#include "utils/timing.h"       /* IterationTimer */
 #include "norm.hip.h"
+#include "stats.hip.h"
 
 
 ///----------------------------------------------------------------------------
@@ -18,26 +28,331 @@ void bm_reduce_norm(benchmark::State &state) {
     // Fill the vector
     thrust::sequence(X.begin(), X.end());
 
+    benchutils::IterationTimer timer(state);
     for (auto _ : state) {
-        benchmark::DoNotOptimize(run_norm(X));
-        hipDeviceSynchronize();
+        timer.time([&] { benchmark::DoNotOptimize(run_norm(X)); });
     }
 
-    state.SetBytesProcessed(int64_t(state.iterations())
-                            * int64_t(sizeof(T) * N << 20));
+    benchutils::setTrafficCounters(state, traffic_norm<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Vector statistics in a single transform_reduce
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_stats_fused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Allocate memory for the device vector
+    thrust::device_vector<T> X(N << 20);
+
+    // Fill the vector
+    thrust::sequence(X.begin(), X.end());
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_stats(X)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_stats<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Vector statistics with one pass per statistic
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_stats_separate(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Allocate memory for the device vector
+    thrust::device_vector<T> X(N << 20);
+
+    // Fill the vector
+    thrust::sequence(X.begin(), X.end());
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_stats_separate(X)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_stats_separate<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// transform_reduce for norm for 1K to 4M items, launch latency
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_reduce_norm_latency(benchmark::State &state) {
+
+    // Number of items
+    size_t n = state.range(0);
+
+    // Allocate a device vector
+    thrust::device_vector<T> X(n, T(1));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_norm(X)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_norm<T>(n));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// transform_reduce for norm for host vectors, dispatched to host or device
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_reduce_norm_dispatch(benchmark::State &state) {
+
+    // Number of items
+    size_t n = state.range(0);
+
+    // Allocate a host vector
+    thrust::host_vector<T> X(n, T(1));
+
+    // Calibrate the crossover before timing, if needed
+    dispatch_norm(X);
+
+    // Host calls are not seen by events
+    benchutils::IterationTimer timer(state, benchutils::options().timing_batch,
+                                     /* events */ false);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(dispatch_norm(X)); });
+    }
+
+    timer.setCounters();
+    state.SetLabel(n < norm_crossover<T>() ? "host" : "device");
+}
+
+
+///----------------------------------------------------------------------------
+/// Norms of a batch of small vectors, one launch per batch
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_reduce_norm_batched(benchmark::State &state) {
+
+    // Number of vectors in a batch, random lengths of 1 to 511 items
+    size_t n_vectors = state.range(0);
+    auto lengths     = benchutils::random_lengths(n_vectors, 256);
+
+    thrust::device_vector<size_t> offsets = benchutils::make_offsets(lengths);
+    size_t n = offsets.back();
+
+    // Allocate flat buffers
+    thrust::device_vector<T> X(n, T(1));
+    thrust::device_vector<T> norms(n_vectors);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_norm_batched(X, offsets, norms); });
+    }
+
+    benchutils::setTrafficCounters(state,
+                                   traffic_norm_batched<T>(n, n_vectors));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Norms of a batch of small vectors, one call per vector
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_reduce_norm_looped(benchmark::State &state) {
+
+    // Number of vectors in a batch, random lengths of 1 to 511 items
+    size_t n_vectors = state.range(0);
+    auto lengths     = benchutils::random_lengths(n_vectors, 256);
+    size_t n = thrust::reduce(lengths.begin(), lengths.end());
+
+    // Allocate one device vector per problem
+    std::vector<thrust::device_vector<T>> vectors;
+    for (auto length : lengths)
+        vectors.emplace_back(length, T(1));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] {
+            for (auto &X : vectors)
+                benchmark::DoNotOptimize(run_norm(X));
+        });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_norm<T>(n));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Norm of a host vector larger than a device buffer, chunk by chunk
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_reduce_norm_streaming(benchmark::State &state) {
+
+    // Number of items (million), chunk size (MiB), device buffers and
+    // host memory of the input
+    size_t N         = state.range(0);
+    size_t chunk     = (size_t(state.range(1)) << 20) / sizeof(T);
+    int    n_buffers = int(state.range(2));
+    auto   kind      = gpuutils::HostMemory(state.range(3));
+    bool   pinned    = kind == gpuutils::HostMemory::pinned;
+
+    // The input stays on host, the device only holds the buffers. Pinned
+    // input is copied to device as is, pageable input is staged first.
+    thrust::host_vector<T> X(pinned ? 0 : N << 20, T(1));
+    std::unique_ptr<gpuutils::HostBuffer> P;
+    if (pinned) {
+        P.reset(new gpuutils::HostBuffer((N << 20) * sizeof(T), kind));
+        auto data = reinterpret_cast<T*>(P->data());
+        std::fill(data, data + (N << 20), T(1));
+    }
+    gpuutils::StreamingReducer<T> reducer(chunk, n_buffers);
+
+    // Copies and reductions run on pipeline streams
+    benchutils::IterationTimer timer(state, benchutils::options().timing_batch,
+                                     /* events */ false);
+    for (auto _ : state) {
+        timer.time([&] {
+            benchmark::DoNotOptimize(pinned
+                ? run_norm_streaming(reducer,
+                                     reinterpret_cast<T*>(P->data()), N << 20)
+                : run_norm_streaming(reducer, X));
+        });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_norm_streaming<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel(gpuutils::hostMemoryName(kind));
+}
+
+
+/// \brief Arguments (million items, chunk MiB, buffers, host memory) for
+///        streaming, pageable and pinned input
+void bm_reduce_norm_streaming_arguments(benchmark::internal::Benchmark *b) {
+    for (auto kind : {gpuutils::HostMemory::pageable,
+                      gpuutils::HostMemory::pinned})
+        for (int n_buffers = 1; n_buffers <= 3; ++n_buffers)
+            for (int chunk = 4; chunk <= 256; chunk *= 4)
+                b->Args({1024, chunk, n_buffers, int(kind)});
+}
+
+
+///----------------------------------------------------------------------------
+/// Norm of materialized or generated inputs
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_reduce_norm_input(benchmark::State &state) {
+
+    // Number of items (million) and input kind
+    size_t N  = state.range(0);
+    auto kind = benchutils::InputKind(state.range(1));
+
+    // Only a materialized input is read from memory
+    auto traffic = kind == benchutils::InputKind::materialized
+                 ? traffic_norm<T>(N << 20)
+                 : traffic_norm_generated<T>(N << 20);
+
+    benchutils::withInput<T>(kind, N << 20, [&](auto X) {
+        benchutils::IterationTimer timer(state);
+        for (auto _ : state) {
+            timer.time([&] {
+                benchmark::DoNotOptimize(run_norm_input<T>(X, N << 20));
+            });
+        }
+
+        benchutils::setTrafficCounters(state, traffic);
+        timer.setCounters();
+    });
+
+    state.SetLabel(benchutils::inputKindName(kind));
 }
 
 
 /// Benchmark registration
 BENCHMARK_TEMPLATE(bm_reduce_norm, float)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(8)
     ->Range(1, 1024 * 3);
 
 BENCHMARK_TEMPLATE(bm_reduce_norm, double)
-    ->UseRealTime()
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(8)
+    ->Range(1, 1024);
+
+BENCHMARK_TEMPLATE(bm_stats_fused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(8)
+    ->Range(1, 1024 * 3);
+
+BENCHMARK_TEMPLATE(bm_stats_fused, double)
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(8)
     ->Range(1, 1024);
 
+BENCHMARK_TEMPLATE(bm_stats_separate, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(8)
+    ->Range(1, 1024 * 3);
+
+BENCHMARK_TEMPLATE(bm_stats_separate, double)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(8)
+    ->Range(1, 1024);
+
+BENCHMARK_TEMPLATE(bm_reduce_norm_latency, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(bm_reduce_norm_dispatch, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(bm_reduce_norm_batched, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(10)
+    ->Range(1, 100000);
+
+BENCHMARK_TEMPLATE(bm_reduce_norm_looped, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(10)
+    ->Range(1, 100000);
+
+BENCHMARK_TEMPLATE(bm_reduce_norm_streaming, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(bm_reduce_norm_streaming_arguments);
+
+BENCHMARK_TEMPLATE(bm_reduce_norm_input, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(benchutils::inputArguments);
+
+
+/// Cold-start registration, first calls on 1M items
+COLD_START("run_norm<float>", [] {
+    auto X = std::make_shared<thrust::device_vector<float>>(1 << 20, 1.f);
+    return [X] { benchmark::DoNotOptimize(run_norm(*X)); };
+});
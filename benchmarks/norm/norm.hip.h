@@ -1,12 +1,23 @@
 #ifndef BENCHMARK_NORM_H_
 #define BENCHMARK_NORM_H_
 
+#include <benchmark/benchmark.h>
 #include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
 #include <thrust/functional.h>
+#include <thrust/host_vector.h>
 #include <thrust/sequence.h>
+#include <thrust/transform.h>
 #include <thrust/transform_reduce.h>
+#include <thrust/iterator/transform_iterator.h>
 #include <cmath>
 
+#include "utils/allocators.h"    /* policy */
+#include "utils/dispatch.h"      /* crossover */
+#include "utils/segments.h"      /* reduce_segments */
+#include "utils/streaming.h"     /* StreamingReducer */
+#include "utils/traffic.h"       /* Traffic */
+
 
 /// \brief A functor for computing the square of a number f(x) -> x*x
 template <typename T>
@@ -25,6 +36,7 @@ T run_norm(thrust::device_vector<T> &X) {
 
     return std::sqrt(
             thrust::transform_reduce(
+                gpuutils::policy(),
                 X.begin(), X.end(), // InputIterator  begin, InputIterator end
                 square<T>(),        // UnaryFunction  unary_op
                 T(0),               // OutputType     init
@@ -34,4 +46,154 @@ T run_norm(thrust::device_vector<T> &X) {
 }
 
 
+/// \brief Traffic of run_norm, read X, a multiplication and an addition
+template <typename T>
+benchutils::Traffic traffic_norm(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 0, 2);
+}
+
+
+///----------------------------------------------------------------------------
+/// Generated inputs
+///----------------------------------------------------------------------------
+
+/// \brief Compute sqrt(x*x) of n items of an input iterator on device
+/// \details The iterator is a vector iterator, or a fancy iterator computing
+///          items from their index so that the input is never stored.
+template <typename T, typename Iterator>
+T run_norm_input(Iterator first, size_t n) {
+    return std::sqrt(thrust::transform_reduce(gpuutils::policy(),
+                                              first, first + n, square<T>(),
+                                              T(0), thrust::plus<T>()));
+}
+
+
+/// \brief Traffic of run_norm_input for a generated input
+template <typename T>
+benchutils::Traffic traffic_norm_generated(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 0, 0, 2);
+}
+
+
+///----------------------------------------------------------------------------
+/// Batched small problems
+///----------------------------------------------------------------------------
+
+/// \brief A functor for computing the square root of a number
+template <typename T>
+struct square_root {
+
+    __host__ __device__
+    T operator()(const T& x) const {
+        return std::sqrt(x);
+    }
+};
+
+
+/// \brief Compute sqrt(x*x) of many vectors stored in a flat buffer
+/// \details Squares are summed up with one reduce_by_key, and square roots
+///          are taken with one transform over the sums.
+/// \param X       Items of all vectors
+/// \param offsets Offsets of vectors in X, n_vectors + 1 items
+/// \param norms   Norms of vectors, n_vectors items
+template <typename T>
+void run_norm_batched(thrust::device_vector<T> &X,
+                      thrust::device_vector<size_t> &offsets,
+                      thrust::device_vector<T> &norms) {
+
+    benchutils::reduce_segments(
+        thrust::make_transform_iterator(X.begin(), square<T>()),
+        offsets, norms);
+
+    thrust::transform(gpuutils::policy(), norms.begin(), norms.end(),
+                      norms.begin(), square_root<T>());
+}
+
+
+/// \brief Traffic of run_norm_batched
+template <typename T>
+benchutils::Traffic traffic_norm_batched(size_t n, size_t n_vectors) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 0, 2)
+         + benchutils::Traffic::items(n_vectors, sizeof(T) + sizeof(size_t),
+                                      0, 1)
+         + benchutils::Traffic::items(n_vectors, sizeof(T), 1, 1, 1);
+}
+
+
+///----------------------------------------------------------------------------
+/// Host/device dispatch
+///----------------------------------------------------------------------------
+
+/// \brief Compute sqrt(x*x) of a host vector with the host system
+template <typename T>
+T host_norm(const thrust::host_vector<T> &X) {
+    return std::sqrt(
+            thrust::transform_reduce(thrust::host, X.begin(), X.end(),
+                                     square<T>(), T(0), thrust::plus<T>()));
+}
+
+
+/// \brief Compute sqrt(x*x) of a host vector on device, copy included
+template <typename T>
+T device_norm(const thrust::host_vector<T> &X) {
+    thrust::device_vector<T> dev_X(X);
+    return run_norm(dev_X);
+}
+
+
+/// \brief Get the size from which dispatch_norm runs on device
+template <typename T>
+size_t norm_crossover() {
+    static const size_t crossover = benchutils::crossover(
+        benchutils::tuningKey<T>("norm"),
+        [](size_t n) { return thrust::host_vector<T>(n, T(1)); },
+        [](thrust::host_vector<T> &X) {
+            benchmark::DoNotOptimize(host_norm(X));
+        },
+        [](thrust::host_vector<T> &X) {
+            benchmark::DoNotOptimize(device_norm(X));
+        });
+
+    return crossover;
+}
+
+
+/// \brief Compute sqrt(x*x) of a host vector on host below the crossover size
+template <typename T>
+T dispatch_norm(const thrust::host_vector<T> &X) {
+    return X.size() < norm_crossover<T>() ? host_norm(X) : device_norm(X);
+}
+
+
+///----------------------------------------------------------------------------
+/// Out-of-core streaming
+///----------------------------------------------------------------------------
+
+/// \brief Compute sqrt(x*x) of a host vector on device, chunk by chunk
+template <typename T>
+T run_norm_streaming(gpuutils::StreamingReducer<T> &reducer,
+                     const thrust::host_vector<T> &X) {
+    return std::sqrt(reducer.transformReduce(X.begin(), X.end(), square<T>(),
+                                             T(0), thrust::plus<T>()));
+}
+
+
+/// \brief Compute sqrt(x*x) of n items of pinned host memory on device,
+///        chunk by chunk, copied with no staging
+template <typename T>
+T run_norm_streaming(gpuutils::StreamingReducer<T> &reducer,
+                     const T *X, size_t n) {
+    return std::sqrt(reducer.transformReducePinned(X, X + n, square<T>(),
+                                                   T(0), thrust::plus<T>()));
+}
+
+
+/// \brief Traffic of run_norm_streaming, copy X to device and read it,
+///        a multiplication and an addition per item
+template <typename T>
+benchutils::Traffic traffic_norm_streaming(size_t n) {
+    return benchutils::Traffic::transfer(n, sizeof(T))
+         + benchutils::Traffic::items(n, sizeof(T), 1, 0, 2);
+}
+
 #endif  // BENCHMARK_NORM_H_
@@ -0,0 +1,195 @@
+#ifndef BENCHMARK_NORM_STATS_H_
+#define BENCHMARK_NORM_STATS_H_
+
+#include <thrust/device_vector.h>
+#include <thrust/extrema.h>
+#include <thrust/functional.h>
+#include <thrust/reduce.h>
+#include <thrust/transform_reduce.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "norm.hip.h"   /* square */
+
+#include "utils/allocators.h"    /* policy */
+#include "utils/traffic.h"       /* Traffic */
+
+
+///----------------------------------------------------------------------------
+/// \struct vector_stats
+/// \brief  Statistics of a vector computed in a single pass
+///----------------------------------------------------------------------------
+template <typename T>
+struct vector_stats {
+
+    uint64_t count;     ///< Number of items
+    T sum;              ///< Sum of items
+    T sum_sq;           ///< Sum of squares
+    T sum_abs;          ///< Sum of absolute values
+    T min;              ///< Minimum
+    T max;              ///< Maximum
+    T max_abs;          ///< Maximum absolute value
+    T mean;             ///< Running mean (Welford)
+    T m2;               ///< Sum of squared deviations from the mean (Welford)
+
+    /// \brief Statistics of an empty vector, the identity of the merge
+    __host__ __device__
+    static vector_stats empty() {
+        return vector_stats{0, T(0), T(0), T(0),
+                            std::numeric_limits<T>::max(),
+                            std::numeric_limits<T>::lowest(),
+                            T(0), T(0), T(0)};
+    }
+
+    /// \brief Population variance
+    __host__ __device__
+    T variance() const {
+        return count > 0 ? m2 / T(count) : T(0);
+    }
+
+    T l1() const   { return sum_abs; }
+    T l2() const   { return std::sqrt(sum_sq); }
+    T linf() const { return max_abs; }
+};
+
+
+/// \brief A functor for computing the statistics of a single item
+template <typename T>
+struct stats_unary {
+
+    __host__ __device__
+    vector_stats<T> operator()(const T &x) const {
+        T a = x < T(0) ? -x : x;
+        return vector_stats<T>{1, x, x * x, a, x, x, a, x, T(0)};
+    }
+};
+
+
+/// \brief A functor for merging statistics of two partitions
+/// \details Means and squared deviations are merged with the pairwise
+///          update of Chan et al., which keeps the variance accurate
+///          for long vectors.
+template <typename T>
+struct stats_merge {
+
+    __host__ __device__
+    vector_stats<T> operator()(const vector_stats<T> &a,
+                               const vector_stats<T> &b) const {
+        if (a.count == 0)
+            return b;
+        if (b.count == 0)
+            return a;
+
+        vector_stats<T> r;
+        r.count   = a.count + b.count;
+        r.sum     = a.sum + b.sum;
+        r.sum_sq  = a.sum_sq + b.sum_sq;
+        r.sum_abs = a.sum_abs + b.sum_abs;
+        r.min     = b.min < a.min ? b.min : a.min;
+        r.max     = a.max < b.max ? b.max : a.max;
+        r.max_abs = a.max_abs < b.max_abs ? b.max_abs : a.max_abs;
+
+        T delta  = b.mean - a.mean;
+        T weight = T(b.count) / T(r.count);
+        r.mean   = a.mean + delta * weight;
+        r.m2     = a.m2 + b.m2 + delta * delta * T(a.count) * weight;
+
+        return r;
+    }
+};
+
+
+/// \brief Compute all statistics with a single transform_reduce
+template <typename T>
+vector_stats<T> run_stats(thrust::device_vector<T> &X) {
+
+    return thrust::transform_reduce(
+                gpuutils::policy(),
+                X.begin(), X.end(),         // InputIterator  begin, InputIterator end
+                stats_unary<T>(),           // UnaryFunction  unary_op
+                vector_stats<T>::empty(),   // OutputType     init
+                stats_merge<T>()            // BinaryFunction binary_op
+           );
+}
+
+
+/// \brief Traffic of run_stats, read X once
+/// \details A square per item and a merge of 12 FLOPs: three sums, the
+///          difference of means, the weight, the mean and the deviations.
+template <typename T>
+benchutils::Traffic traffic_stats(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 0, 13);
+}
+
+
+/// \brief A functor for computing |x|
+template <typename T>
+struct absolute {
+
+    __host__ __device__
+    T operator()(const T &x) const {
+        return x < T(0) ? -x : x;
+    }
+};
+
+
+/// \brief A functor for computing (x - mean)^2
+template <typename T>
+struct squared_deviation {
+
+    T mean;
+
+    __host__ __device__
+    T operator()(const T &x) const {
+        return (x - mean) * (x - mean);
+    }
+};
+
+
+/// \brief Compute the same statistics with one pass per statistic
+/// \details Seven passes: sum, sum of squares, sum of absolute values,
+///          minimum, maximum, maximum absolute value and the deviations
+///          from the mean.
+template <typename T>
+vector_stats<T> run_stats_separate(thrust::device_vector<T> &X) {
+
+    auto identity = vector_stats<T>::empty();
+
+    vector_stats<T> r;
+    r.count   = X.size();
+    r.sum     = thrust::reduce(gpuutils::policy(),
+                               X.begin(), X.end(), T(0), thrust::plus<T>());
+    r.sum_sq  = thrust::transform_reduce(gpuutils::policy(),
+                                         X.begin(), X.end(), square<T>(),
+                                         T(0), thrust::plus<T>());
+    r.sum_abs = thrust::transform_reduce(gpuutils::policy(),
+                                         X.begin(), X.end(), absolute<T>(),
+                                         T(0), thrust::plus<T>());
+    r.min     = thrust::reduce(gpuutils::policy(),
+                               X.begin(), X.end(), identity.min,
+                               thrust::minimum<T>());
+    r.max     = thrust::reduce(gpuutils::policy(),
+                               X.begin(), X.end(), identity.max,
+                               thrust::maximum<T>());
+    r.max_abs = thrust::transform_reduce(gpuutils::policy(),
+                                         X.begin(), X.end(), absolute<T>(),
+                                         T(0), thrust::maximum<T>());
+    r.mean    = r.count > 0 ? r.sum / T(r.count) : T(0);
+    r.m2      = thrust::transform_reduce(gpuutils::policy(), X.begin(), X.end(),
+                                         squared_deviation<T>{r.mean},
+                                         T(0), thrust::plus<T>());
+    return r;
+}
+
+
+/// \brief Traffic of run_stats_separate, read X seven times
+/// \details One FLOP for each sum, two for the squares and three for the
+///          deviations; minima and maxima are comparisons.
+template <typename T>
+benchutils::Traffic traffic_stats_separate(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 7, 0, 7);
+}
+
+
+#endif  // BENCHMARK_NORM_STATS_H_
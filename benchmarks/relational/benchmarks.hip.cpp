@@ -0,0 +1,152 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "utils/cold_start.h"   /* COLD_START */
+#include "utils/counters.h"     /* allocator and traffic counters */
+#include "utils/timing.h"       /* IterationTimer */
+#include "relational.hip.h"
+
+
+/// \brief Get a label of the keys of a relation, "card=2^c skew=s.s"
+std::string relation_label(int card_log2, int skew_x10) {
+    return "card=2^" + std::to_string(card_log2)
+         + " skew=" + std::to_string(skew_x10 / 10)
+         + "." + std::to_string(skew_x10 % 10);
+}
+
+
+///----------------------------------------------------------------------------
+/// Group-by with count, sum, min and max of values
+///----------------------------------------------------------------------------
+template <typename K, typename V>
+void bm_group_by(benchmark::State &state) {
+
+    // Number of rows (million), log2 of key cardinality, skew (x10)
+    size_t N         = state.range(0);
+    int card_log2    = int(state.range(1));
+    int skew_x10     = int(state.range(2));
+    double skew      = skew_x10 / 10.;
+    size_t card      = size_t(1) << card_log2;
+
+    // Make rows and allocate groups
+    relation<K, V> R(N << 20);
+    make_relation(R, card, skew);
+    thrust::device_vector<K> keys(std::min(N << 20, card));
+    thrust::device_vector<group_aggregates<V>> aggregates(keys.size());
+
+    size_t groups = 0;
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { groups = run_group_by(R, keys, aggregates); });
+    }
+
+    benchutils::setTrafficCounters(state,
+                                   traffic_group_by<K, V>(N << 20, groups));
+    timer.setCounters();
+    state.counters["groups"] = double(groups);
+    state.SetLabel(relation_label(card_log2, skew_x10));
+}
+
+
+///----------------------------------------------------------------------------
+/// Distinct keys
+///----------------------------------------------------------------------------
+template <typename K, typename V>
+void bm_distinct(benchmark::State &state) {
+
+    // Number of rows (million), log2 of key cardinality, skew (x10)
+    size_t N         = state.range(0);
+    int card_log2    = int(state.range(1));
+    int skew_x10     = int(state.range(2));
+    double skew      = skew_x10 / 10.;
+
+    // Make rows
+    relation<K, V> R(N << 20);
+    make_relation(R, size_t(1) << card_log2, skew);
+
+    size_t distinct = 0;
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { distinct = run_distinct(R); });
+    }
+
+    benchutils::setTrafficCounters(state,
+                                   traffic_distinct<K>(N << 20, distinct));
+    timer.setCounters();
+    state.counters["distinct"] = double(distinct);
+    state.SetLabel(relation_label(card_log2, skew_x10));
+}
+
+
+///----------------------------------------------------------------------------
+/// Sort-merge equi-join of N probe rows with a build side of their keys
+///----------------------------------------------------------------------------
+template <typename K, typename V>
+void bm_join(benchmark::State &state) {
+
+    // Number of probe rows (million), log2 of key cardinality, skew (x10)
+    size_t N         = state.range(0);
+    int card_log2    = int(state.range(1));
+    int skew_x10     = int(state.range(2));
+    double skew      = skew_x10 / 10.;
+    size_t card      = size_t(1) << card_log2;
+
+    // Make a build side of one row per key on average, uniform, so that
+    // about N rows match, and a skewed probe side
+    relation<K, V> R(card), S(N << 20);
+    make_relation(R, card, 0., 7);
+    make_relation(S, card, skew);
+    joined<K, V> out;
+
+    size_t matches = 0;
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { matches = run_join(R, S, out); });
+    }
+
+    benchutils::setTrafficCounters(state,
+                                   traffic_join<K, V>(card, N << 20, matches));
+    timer.setCounters();
+    state.counters["matches"] = double(matches);
+    state.SetLabel(relation_label(card_log2, skew_x10));
+}
+
+
+/// \brief Arguments (million rows, log2 of key cardinality, skew x10)
+void relational_arguments(benchmark::internal::Benchmark *b) {
+    for (int skew : {0, 10})
+        for (int card_log2 : {8, 14, 20})
+            for (int N : {16, 64})
+                b->Args({N, card_log2, skew});
+}
+
+
+/// Benchmark registration
+BENCHMARK_TEMPLATE(bm_group_by, uint32_t, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(relational_arguments);
+
+BENCHMARK_TEMPLATE(bm_distinct, uint32_t, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(relational_arguments);
+
+BENCHMARK_TEMPLATE(bm_join, uint32_t, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(relational_arguments);
+
+
+/// Cold-start registration, first calls on 1M rows
+COLD_START("run_group_by<uint32_t,float>", [] {
+    auto R = std::make_shared<relation<uint32_t, float>>(1 << 20);
+    make_relation(*R, 1 << 14, 0.);
+    auto keys = std::make_shared<thrust::device_vector<uint32_t>>(1 << 14);
+    auto aggregates = std::make_shared<
+        thrust::device_vector<group_aggregates<float>>>(1 << 14);
+    return [R, keys, aggregates] { run_group_by(*R, *keys, *aggregates); };
+});
@@ -0,0 +1,333 @@
+#ifndef BENCHMARK_RELATIONAL_H_
+#define BENCHMARK_RELATIONAL_H_
+
+#include <thrust/binary_search.h>
+#include <thrust/device_vector.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/tuple.h>
+#include <thrust/unique.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <cstdint>
+#include <stdexcept>
+
+#include "utils/allocators.h"    /* policy, temporary_vector */
+#include "utils/generators.h"    /* generate */
+#include "utils/segments.h"      /* segment_of */
+#include "utils/traffic.h"       /* Traffic */
+
+
+///----------------------------------------------------------------------------
+/// Relations
+///----------------------------------------------------------------------------
+
+///< Type of row ids
+using row_id = uint32_t;
+
+
+/// \brief A relation of rows (key, value), as two columns
+template <typename K, typename V>
+struct relation {
+
+    thrust::device_vector<K> keys;
+    thrust::device_vector<V> values;
+
+    relation() = default;
+
+    explicit relation(size_t n) : keys(n), values(n) {}
+
+    size_t size() const { return keys.size(); }
+};
+
+
+/// \brief A functor for a key in [0, cardinality), f(x) -> x % cardinality
+template <typename K>
+struct key_modulo {
+
+    K cardinality;
+
+    __host__ __device__
+    K operator()(const K &x) const {
+        return x % cardinality;
+    }
+};
+
+
+/// \brief Fill the keys of a relation with a cardinality and a skew
+/// \details Keys are uniform in [0, cardinality), or Zipf ranks folded into
+///          [0, cardinality) for a skew s > 0, the exponent of the ranks, so
+///          that key 0 is the most frequent. Values are uniform in [-1, 1).
+/// \param R           Relation to fill
+/// \param cardinality Number of possible keys
+/// \param skew        Zipf exponent, 0 for uniform keys
+/// \param seed        Seed of the keys and values
+template <typename K, typename V>
+void make_relation(relation<K, V> &R, size_t cardinality, double skew,
+                   uint64_t seed = 42) {
+
+    if (cardinality == 0)
+        throw std::invalid_argument("A relation needs one key or more");
+
+    using benchutils::DataSpec;
+    using benchutils::Distribution;
+
+    benchutils::generate(R.keys, skew > 0
+                                 ? DataSpec(Distribution::zipf, seed, skew)
+                                 : DataSpec(Distribution::uniform, seed));
+    thrust::transform(R.keys.begin(), R.keys.end(), R.keys.begin(),
+                      key_modulo<K>{K(cardinality)});
+
+    benchutils::generate(R.values, DataSpec(Distribution::uniform, ~seed));
+}
+
+
+///----------------------------------------------------------------------------
+/// Group-by: sort_by_key and reduce_by_key
+///----------------------------------------------------------------------------
+
+/// \brief Aggregates of the values of a group
+template <typename V>
+struct group_aggregates {
+    uint32_t count;
+    V        sum;
+    V        min;
+    V        max;
+};
+
+
+/// \brief A functor for lifting a value to the aggregates of its row
+template <typename V>
+struct to_aggregates {
+
+    __host__ __device__
+    group_aggregates<V> operator()(const V &x) const {
+        return group_aggregates<V>{1, x, x, x};
+    }
+};
+
+
+/// \brief A functor for merging the aggregates of two parts of a group
+template <typename V>
+struct merge_aggregates {
+
+    __host__ __device__
+    group_aggregates<V> operator()(const group_aggregates<V> &a,
+                                   const group_aggregates<V> &b) const {
+        return group_aggregates<V>{a.count + b.count, a.sum + b.sum,
+                                   b.min < a.min ? b.min : a.min,
+                                   a.max < b.max ? b.max : a.max};
+    }
+};
+
+
+/// \brief Group rows by key, with the count, sum, min and max of values
+/// \details Rows are copied to temporaries and sorted by key, then each
+///          run of equal keys is reduced, values lifted to aggregates on
+///          the fly. R is not modified.
+/// \param R          Rows
+/// \param keys       Keys of groups, at least as many items as groups
+/// \param aggregates Aggregates of groups, as many items as keys
+/// \return Number of groups
+template <typename K, typename V>
+size_t run_group_by(relation<K, V> &R, thrust::device_vector<K> &keys,
+                    thrust::device_vector<group_aggregates<V>> &aggregates) {
+
+    gpuutils::temporary_vector<K> sorted_keys(R.keys.begin(), R.keys.end());
+    gpuutils::temporary_vector<V> sorted_values(R.values.begin(),
+                                                R.values.end());
+
+    thrust::sort_by_key(gpuutils::policy(),
+                        sorted_keys.begin(), sorted_keys.end(),
+                        sorted_values.begin());
+
+    auto lifted = thrust::make_transform_iterator(sorted_values.begin(),
+                                                  to_aggregates<V>());
+    auto ends   = thrust::reduce_by_key(gpuutils::policy(),
+                                        sorted_keys.begin(), sorted_keys.end(),
+                                        lifted,
+                                        keys.begin(), aggregates.begin(),
+                                        thrust::equal_to<K>(),
+                                        merge_aggregates<V>());
+
+    return ends.first - keys.begin();
+}
+
+
+/// \brief Traffic of run_group_by of n rows into g groups
+/// \details Copy the rows, sort them, read them and write the groups; 4
+///          operations per row merge aggregates.
+template <typename K, typename V>
+benchutils::Traffic traffic_group_by(size_t n, size_t g) {
+    return benchutils::Traffic::items(n, sizeof(K) + sizeof(V), 3, 2, 4)
+         + benchutils::Traffic::items(g, sizeof(K)
+                                         + sizeof(group_aggregates<V>), 0, 1);
+}
+
+
+///----------------------------------------------------------------------------
+/// Distinct: sort and unique
+///----------------------------------------------------------------------------
+
+/// \brief Count the distinct keys of a relation
+/// \details Keys are copied to a temporary, sorted and made unique in
+///          place. R is not modified.
+template <typename K, typename V>
+size_t run_distinct(relation<K, V> &R) {
+
+    gpuutils::temporary_vector<K> keys(R.keys.begin(), R.keys.end());
+
+    thrust::sort(gpuutils::policy(), keys.begin(), keys.end());
+    auto end = thrust::unique(gpuutils::policy(), keys.begin(), keys.end());
+
+    return end - keys.begin();
+}
+
+
+/// \brief Traffic of run_distinct of n keys into d distinct ones
+template <typename K>
+benchutils::Traffic traffic_distinct(size_t n, size_t d) {
+    return benchutils::Traffic::items(n, sizeof(K), 3, 2)
+         + benchutils::Traffic::items(d, sizeof(K), 0, 1);
+}
+
+
+///----------------------------------------------------------------------------
+/// Equi-join: sort-merge with binary searches
+///----------------------------------------------------------------------------
+
+/// \brief Rows of an equi-join, key and value of each side
+template <typename K, typename V>
+struct joined {
+
+    thrust::device_vector<K> keys;
+    thrust::device_vector<V> left;      ///< Values of rows of R
+    thrust::device_vector<V> right;     ///< Values of rows of S
+
+    size_t size() const { return keys.size(); }
+
+    void resize(size_t n) {
+        keys.resize(n);
+        left.resize(n);
+        right.resize(n);
+    }
+};
+
+
+/// \brief A functor for the length of a range (first, last), last - first
+struct range_length {
+
+    template <typename Tuple>
+    __host__ __device__
+    size_t operator()(const Tuple &range) const {
+        return thrust::get<1>(range) - thrust::get<0>(range);
+    }
+};
+
+
+/// \brief A functor for the row of R of an output row o of a join
+/// \details Output rows of S row s are [offsets[s], offsets[s + 1]), their
+///          matches are the sorted rows of R from first[s].
+struct left_row {
+
+    benchutils::segment_of row_of;      ///< Row of S of an output row
+    const size_t          *offsets;
+    const size_t          *first;
+    const row_id          *rows;        ///< Rows of R in order of keys
+
+    __host__ __device__
+    row_id operator()(size_t o) const {
+        size_t s = row_of(o);
+        return rows[first[s] + (o - offsets[s])];
+    }
+};
+
+
+/// \brief Join the rows of two relations on equal keys
+/// \details Keys of R are sorted with their row ids. For each row of S,
+///          lower_bound and upper_bound find its matches in R, a scan of
+///          their counts gives the offsets of its output rows, and output
+///          rows gather keys and values of both sides. R and S are not
+///          modified.
+/// \param R   Left relation, the build side
+/// \param S   Right relation, the probe side
+/// \param out Rows of the join, resized
+/// \return Number of rows of the join
+template <typename K, typename V>
+size_t run_join(relation<K, V> &R, relation<K, V> &S, joined<K, V> &out) {
+
+    size_t n_r = R.size(), n_s = S.size();
+    auto policy = gpuutils::policy();
+
+    // Sort keys of R with their row ids
+    gpuutils::temporary_vector<K> r_keys(R.keys.begin(), R.keys.end());
+    gpuutils::temporary_vector<row_id> r_rows(n_r);
+    thrust::sequence(policy, r_rows.begin(), r_rows.end());
+    thrust::sort_by_key(policy, r_keys.begin(), r_keys.end(),
+                        r_rows.begin());
+
+    // Matches [first, last) of each row of S among sorted rows of R
+    gpuutils::temporary_vector<size_t> first(n_s), last(n_s);
+    thrust::lower_bound(policy, r_keys.begin(), r_keys.end(),
+                        S.keys.begin(), S.keys.end(), first.begin());
+    thrust::upper_bound(policy, r_keys.begin(), r_keys.end(),
+                        S.keys.begin(), S.keys.end(), last.begin());
+
+    // Offsets of output rows, 0 followed by the sums of match counts
+    auto counts = thrust::make_transform_iterator(
+                      thrust::make_zip_iterator(thrust::make_tuple(
+                          first.begin(), last.begin())),
+                      range_length());
+    gpuutils::temporary_vector<size_t> offsets(n_s + 1, 0);
+    thrust::inclusive_scan(policy, counts, counts + n_s,
+                           offsets.begin() + 1);
+
+    size_t n_out = offsets[n_s];
+    out.resize(n_out);
+
+    // Rows of both sides of each output row
+    auto offsets_ptr = thrust::raw_pointer_cast(offsets.data());
+    benchutils::segment_of row_of{offsets_ptr, n_s};
+
+    auto s_rows = thrust::make_transform_iterator(
+                      thrust::make_counting_iterator<size_t>(0), row_of);
+    auto r_rows_out = thrust::make_transform_iterator(
+                          thrust::make_counting_iterator<size_t>(0),
+                          left_row{row_of, offsets_ptr,
+                                   thrust::raw_pointer_cast(first.data()),
+                                   thrust::raw_pointer_cast(r_rows.data())});
+
+    thrust::gather(policy, s_rows, s_rows + n_out,
+                   S.keys.begin(), out.keys.begin());
+    thrust::gather(policy, s_rows, s_rows + n_out,
+                   S.values.begin(), out.right.begin());
+    thrust::gather(policy, r_rows_out, r_rows_out + n_out,
+                   R.values.begin(), out.left.begin());
+
+    return n_out;
+}
+
+
+/// \brief Traffic of run_join of r and s rows into m rows
+/// \details Sort keys and row ids of R, write the match ranges and offsets
+///          of S, gather m keys and 2 m values. Binary searches are
+///          counted as one read of a key of R per row of S.
+template <typename K, typename V>
+benchutils::Traffic traffic_join(size_t r, size_t s, size_t m) {
+    return benchutils::Traffic::items(r, sizeof(K), 2, 2)
+         + benchutils::Traffic::items(r, sizeof(row_id), 1, 2)
+         + benchutils::Traffic::items(s, sizeof(K), 4, 0)
+         + benchutils::Traffic::items(s, sizeof(size_t), 2, 3)
+         + benchutils::Traffic::items(m, sizeof(K) + 2 * sizeof(V), 1, 1)
+         + benchutils::Traffic::items(m, sizeof(row_id) + sizeof(size_t),
+                                      1, 0);
+}
+
+
+#endif  // BENCHMARK_RELATIONAL_H_
@@ -5,14 +5,43 @@ set -e
 #export HIPCC_VERBOSE=7
 #export HIP_DB=0xf
 
+# Thrust device system: HIP, CPP, OMP or TBB
+DEVICE_SYSTEM=${DEVICE_SYSTEM:-HIP}
+
+# Repetitions of each benchmark, kept for compare_results.py
+REPETITIONS=${REPETITIONS:-10}
+
+# Results are written to $RESULTS_DIR/<host>/<commit>/<device system>.json
+RESULTS_DIR=${RESULTS_DIR:-results}
+
+# Keep one build tree per backend so that they can be compared
 BUILD_DIR=build
-RUN_COMMAND="./$BUILD_DIR/run_benchmarks --benchmark_min_time=1"
+if [ "$DEVICE_SYSTEM" != "HIP" ]; then
+    BUILD_DIR=build_${DEVICE_SYSTEM,,}
+fi
+
+# Key results by commit, marking uncommitted changes, and by host
+COMMIT=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+if [ -n "$(git status --porcelain --untracked-files=no 2>/dev/null)" ]; then
+    COMMIT=${COMMIT}-dirty
+fi
+HOST=$(hostname -s)
+RESULTS_FILE=$RESULTS_DIR/$HOST/$COMMIT/${DEVICE_SYSTEM,,}.json
+mkdir -p "$(dirname "$RESULTS_FILE")"
+
+RUN_COMMAND="./$BUILD_DIR/run_benchmarks --benchmark_min_time=1 \
+    --benchmark_repetitions=$REPETITIONS \
+    --benchmark_display_aggregates_only=true \
+    --benchmark_out=$RESULTS_FILE \
+    --benchmark_out_format=json"
 
 # Build benchmarks
 cmake -S . -B $BUILD_DIR \
-    -DCMAKE_BUILD_TYPE=Release
+    -DCMAKE_BUILD_TYPE=Release \
+    -DDEVICE_SYSTEM=$DEVICE_SYSTEM
 cmake --build $BUILD_DIR -j8
 
 # Run benchmarks
 $RUN_COMMAND "$@"
 
+echo "Results written to $RESULTS_FILE"
@@ -1,7 +1,15 @@
 #include <benchmark/benchmark.h>
+#include <vector>
+#include <memory>
 
-#include "utils/gpu_utils.h"    /* getNumGPUs, hipSetDevice */
+#include "utils/segments.h"     /* make_offsets, random_lengths */
+#include "utils/cold_start.h"   /* COLD_START */
+#include "utils/counters.h"     /* allocator and traffic counters */
+#include "utils/inputs.h"       /* InputKind, withInput */
+#include "utils/gpu_utils.h"    /* getNumGPUs, setDevice */
+#include "utils/timing.h"       /* IterationTimer */
 #include "saxpy.hip.h"
+#include "blas1.hip.h"
 
 
 ///----------------------------------------------------------------------------
@@ -13,27 +21,27 @@ void bm_saxpy_fast(benchmark::State &state) {
     // Switch to another GPU
     auto n_gpus = gpuutils::getNumGPUs();
     if (n_gpus > 1)
-        hipSetDevice(n_gpus - 1);
+        gpuutils::setDevice(n_gpus - 1);
 
     // Number of items (million)
     size_t N = state.range(0);
 
     // Define scalar A and allocate memory for vector X and Y
     T A = 2.0;
-    thrust::device_vector<T> X(N << 20);
-    thrust::device_vector<T> Y(N << 20);
+    gpuutils::tracked_vector<T> X(N << 20);
+    gpuutils::tracked_vector<T> Y(N << 20);
 
     // Fill the vectors
     thrust::sequence(X.begin(), X.end());
     thrust::fill(Y.begin(), Y.end(), 1.);
 
+    benchutils::IterationTimer timer(state);
     for (auto _ : state) {
-        run_saxpy_fast(A, X, Y);
-        hipDeviceSynchronize();
+        timer.time([&] { run_saxpy_fast(A, X, Y); });
     }
 
-    state.SetBytesProcessed(int64_t(state.iterations())
-                            * int64_t(sizeof(T) * N << 20));
+    benchutils::setTrafficCounters(state, traffic_saxpy_fast<T>(N << 20));
+    timer.setCounters();
 }
 
 
@@ -46,13 +54,302 @@ void bm_saxpy_slow(benchmark::State &state) {
     // Switch to another GPU
     auto n_gpus = gpuutils::getNumGPUs();
     if (n_gpus > 1)
-        hipSetDevice(n_gpus - 1);
+        gpuutils::setDevice(n_gpus - 1);
 
     // Number of items (million)
     size_t N = state.range(0);
 
     // Define scalar A and allocate memory for vector X and Y
     T A = 2.0;
+    gpuutils::tracked_vector<T> X(N << 20);
+    gpuutils::tracked_vector<T> Y(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+
+    benchutils::resetAllocatorCounters();
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_saxpy_slow(A, X, Y); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_saxpy_slow<T>(N << 20));
+    timer.setCounters();
+    benchutils::setAllocatorCounters(state, timer.batch());
+}
+
+
+///----------------------------------------------------------------------------
+/// Y = A * X + B * Y, blas1 expressions
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_axpby_fused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Define scalars and allocate memory for vectors
+    T A = 2.0, B = 0.5;
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> Y(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_axpby_fused(A, X, B, Y); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_axpby_fused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Y = A * X + B * Y, one thrust call per operation
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_axpby_unfused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Define scalars and allocate memory for vectors
+    T A = 2.0, B = 0.5;
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> Y(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_axpby_unfused(A, X, B, Y); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_axpby_unfused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// W = A * X + B * Y, blas1 expressions
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_waxpby_fused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Define scalars and allocate memory for vectors
+    T A = 2.0, B = 0.5;
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> Y(N << 20);
+    thrust::device_vector<T> W(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+    thrust::fill(W.begin(), W.end(), 1.);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_waxpby_fused(A, X, B, Y, W); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_waxpby_fused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// W = A * X + B * Y, one thrust call per operation
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_waxpby_unfused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Define scalars and allocate memory for vectors
+    T A = 2.0, B = 0.5;
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> Y(N << 20);
+    thrust::device_vector<T> W(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+    thrust::fill(W.begin(), W.end(), 1.);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_waxpby_unfused(A, X, B, Y, W); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_waxpby_unfused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Y = A * X + B * Y + C * Z, blas1 expressions
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_axpbypcz_fused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Define scalars and allocate memory for vectors
+    T A = 2.0, B = 0.5, C = -1.0;
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> Y(N << 20);
+    thrust::device_vector<T> Z(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+    thrust::fill(Z.begin(), Z.end(), 1.);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_axpbypcz_fused(A, X, B, Y, C, Z); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_axpbypcz_fused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Y = A * X + B * Y + C * Z, one thrust call per operation
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_axpbypcz_unfused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Define scalars and allocate memory for vectors
+    T A = 2.0, B = 0.5, C = -1.0;
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> Y(N << 20);
+    thrust::device_vector<T> Z(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+    thrust::fill(Z.begin(), Z.end(), 1.);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_axpbypcz_unfused(A, X, B, Y, C, Z); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_axpbypcz_unfused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// X . Y, blas1 expressions
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_dot_fused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Allocate memory for vectors
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> Y(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_dot_fused(X, Y)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_dot_fused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// X . Y, one thrust call per operation
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_dot_unfused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Allocate memory for vectors
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> Y(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_dot_unfused(X, Y)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_dot_unfused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// ||A * X - Y||, blas1 expressions
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_nrm2_fused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Define scalar A and allocate memory for vectors
+    T A = 2.0;
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> Y(N << 20);
+
+    // Fill the vectors
+    thrust::sequence(X.begin(), X.end());
+    thrust::fill(Y.begin(), Y.end(), 1.);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_nrm2_fused(A, X, Y)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_nrm2_fused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// ||A * X - Y||, one thrust call per operation
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_nrm2_unfused(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Define scalar A and allocate memory for vectors
+    T A = 2.0;
     thrust::device_vector<T> X(N << 20);
     thrust::device_vector<T> Y(N << 20);
 
@@ -60,37 +357,289 @@ void bm_saxpy_slow(benchmark::State &state) {
     thrust::sequence(X.begin(), X.end());
     thrust::fill(Y.begin(), Y.end(), 1.);
 
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] {
+            benchmark::DoNotOptimize(run_nrm2_unfused(A, X, Y));
+        });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_nrm2_unfused<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// saxpy_fast for 1K to 4M items, launch latency
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_saxpy_latency(benchmark::State &state) {
+
+    // Number of items
+    size_t n = state.range(0);
+
+    // Define scalar A and allocate memory for vector X and Y
+    T A = 2.0;
+    gpuutils::tracked_vector<T> X(n, T(1));
+    gpuutils::tracked_vector<T> Y(n, T(1));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_saxpy_fast(A, X, Y); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_saxpy_fast<T>(n));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// saxpy_fast for host vectors, dispatched to host or device
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_saxpy_dispatch(benchmark::State &state) {
+
+    // Number of items
+    size_t n = state.range(0);
+
+    // Define scalar A and allocate memory for vector X and Y
+    T A = 2.0;
+    thrust::host_vector<T> X(n, T(1));
+    thrust::host_vector<T> Y(n, T(1));
+
+    // Calibrate the crossover before timing, if needed
+    dispatch_saxpy(A, X, Y);
+
+    // Host calls are not seen by events
+    benchutils::IterationTimer timer(state, benchutils::options().timing_batch,
+                                     /* events */ false);
+    for (auto _ : state) {
+        timer.time([&] { dispatch_saxpy(A, X, Y); });
+    }
+
+    timer.setCounters();
+    state.SetLabel(n < saxpy_crossover<T>() ? "host" : "device");
+}
+
+
+///----------------------------------------------------------------------------
+/// SAXPYs of a batch of small vectors, one launch per batch
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_saxpy_batched(benchmark::State &state) {
+
+    // Number of vectors in a batch, random lengths of 1 to 511 items
+    size_t n_vectors = state.range(0);
+    auto lengths     = benchutils::random_lengths(n_vectors, 256);
+
+    thrust::device_vector<size_t> offsets = benchutils::make_offsets(lengths);
+    size_t n = offsets.back();
+
+    // Allocate flat buffers
+    thrust::device_vector<T> A(n_vectors, T(2));
+    thrust::device_vector<T> X(n, T(1));
+    thrust::device_vector<T> Y(n, T(1));
+
+    benchutils::IterationTimer timer(state);
     for (auto _ : state) {
-        run_saxpy_slow(A, X, Y);
+        timer.time([&] { run_saxpy_batched(A, X, Y, offsets); });
     }
 
-    state.SetBytesProcessed(int64_t(state.iterations())
-                            * int64_t(sizeof(T) * N << 20));
+    benchutils::setTrafficCounters(state,
+                                   traffic_saxpy_batched<T>(n, n_vectors));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// SAXPYs of a batch of small vectors, one call per vector
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_saxpy_looped(benchmark::State &state) {
+
+    // Number of vectors in a batch, random lengths of 1 to 511 items
+    size_t n_vectors = state.range(0);
+    auto lengths     = benchutils::random_lengths(n_vectors, 256);
+    size_t n = thrust::reduce(lengths.begin(), lengths.end());
+
+    // Allocate one device vector per problem
+    T A = 2.0;
+    std::vector<thrust::device_vector<T>> X, Y;
+    for (auto length : lengths) {
+        X.emplace_back(length, T(1));
+        Y.emplace_back(length, T(1));
+    }
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] {
+            for (size_t s = 0; s < n_vectors; ++s)
+                run_saxpy_fast(A, X[s], Y[s]);
+        });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_saxpy_fast<T>(n));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// SAXPY with materialized or generated X
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_saxpy_input(benchmark::State &state) {
+
+    // Number of items (million) and input kind
+    size_t N  = state.range(0);
+    auto kind = benchutils::InputKind(state.range(1));
+
+    // Define scalar A and allocate memory for vector Y
+    T A = 2.0;
+    thrust::device_vector<T> Y(N << 20, T(1));
+
+    // Only a materialized input is read from memory
+    auto traffic = kind == benchutils::InputKind::materialized
+                 ? traffic_saxpy_fast<T>(N << 20)
+                 : traffic_saxpy_generated<T>(N << 20);
+
+    benchutils::withInput<T>(kind, N << 20, [&](auto X) {
+        benchutils::IterationTimer timer(state);
+        for (auto _ : state) {
+            timer.time([&] { run_saxpy_input(A, X, Y); });
+        }
+
+        benchutils::setTrafficCounters(state, traffic);
+        timer.setCounters();
+    });
+
+    state.SetLabel(benchutils::inputKindName(kind));
 }
 
 
 /// Benchmark registration
 BENCHMARK_TEMPLATE(bm_saxpy_fast, float)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(2)
     ->Range(32, 2000);
 
 BENCHMARK_TEMPLATE(bm_saxpy_fast, double)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(2)
     ->Range(32, 1000);
 
 BENCHMARK_TEMPLATE(bm_saxpy_slow, float)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(4)
     ->Range(32, 1024);
 
 BENCHMARK_TEMPLATE(bm_saxpy_slow, double)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(4)
     ->Range(1, 512);
 
+BENCHMARK_TEMPLATE(bm_axpby_fused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_axpby_unfused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_waxpby_fused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_waxpby_unfused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_axpbypcz_fused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_axpbypcz_unfused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_dot_fused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_dot_unfused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_nrm2_fused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_nrm2_unfused, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(32, 512);
+
+BENCHMARK_TEMPLATE(bm_saxpy_latency, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(bm_saxpy_dispatch, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(bm_saxpy_batched, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(10)
+    ->Range(1, 100000);
+
+BENCHMARK_TEMPLATE(bm_saxpy_looped, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(10)
+    ->Range(1, 100000);
+
+BENCHMARK_TEMPLATE(bm_saxpy_input, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(benchutils::inputArguments);
+
+
+/// Cold-start registration, first calls on 1M items
+COLD_START("run_saxpy_fast<float>", [] {
+    auto X = std::make_shared<thrust::device_vector<float>>(1 << 20, 1.f);
+    auto Y = std::make_shared<thrust::device_vector<float>>(1 << 20, 1.f);
+    return [X, Y] { run_saxpy_fast(2.f, *X, *Y); };
+});
+
+COLD_START("run_saxpy_slow<float>", [] {
+    auto X = std::make_shared<thrust::device_vector<float>>(1 << 20, 1.f);
+    auto Y = std::make_shared<thrust::device_vector<float>>(1 << 20, 1.f);
+    return [X, Y] { run_saxpy_slow(2.f, *X, *Y); };
+});
@@ -0,0 +1,534 @@
+#ifndef BENCHMARK_SAXPY_BLAS1_H_
+#define BENCHMARK_SAXPY_BLAS1_H_
+
+#include <thrust/device_vector.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+#include "utils/allocators.h"    /* policy, temporary_vector */
+#include "utils/traffic.h"       /* Traffic */
+
+
+/// \namespace blas1
+/// \brief     Lazy BLAS-1 expressions over device vectors.
+/// \details   Arithmetic on vectors builds an expression tree instead of
+///            computing anything. A statement is evaluated when it is
+///            assigned to a vector or reduced by dot/nrm2, as a single
+///            transform or transform_reduce over item indices, so no
+///            temporary vectors are allocated.
+///
+///                blas1::vec<float> x(X), y(Y), z(Z);
+///                y = a * x + b * y + c * z;
+///                auto r = blas1::nrm2(a * x - y);
+namespace blas1 {
+
+
+/// \brief Base of all expressions, used for overload resolution
+template <typename E>
+struct expression {};
+
+
+/// \brief Items of a device vector
+template <typename T>
+struct terminal : expression<terminal<T>> {
+
+    using value_type = T;
+
+    const T *data;
+    size_t   n;
+
+    terminal(const T *data, size_t n) : data(data), n(n) {}
+
+    size_t size() const { return n; }
+
+    __host__ __device__
+    T operator[](size_t i) const {
+        return data[i];
+    }
+};
+
+
+/// \brief A scalar times an expression
+template <typename E>
+struct scaled : expression<scaled<E>> {
+
+    using value_type = typename E::value_type;
+
+    value_type a;
+    E          e;
+
+    scaled(value_type a, const E &e) : a(a), e(e) {}
+
+    size_t size() const { return e.size(); }
+
+    __host__ __device__
+    value_type operator[](size_t i) const {
+        return a * e[i];
+    }
+};
+
+
+/// \brief An item-wise binary operation on two expressions
+template <typename L, typename R, typename Op>
+struct binary : expression<binary<L, R, Op>> {
+
+    using value_type = typename L::value_type;
+
+    L l;
+    R r;
+
+    binary(const L &l, const R &r) : l(l), r(r) {
+        if (l.size() != r.size())
+            throw std::invalid_argument("blas1: mismatched vector sizes");
+    }
+
+    size_t size() const { return l.size(); }
+
+    __host__ __device__
+    value_type operator[](size_t i) const {
+        return Op()(l[i], r[i]);
+    }
+};
+
+
+///----------------------------------------------------------------------------
+/// \class vec
+/// \brief A device vector which can be used in and assigned from expressions
+///----------------------------------------------------------------------------
+template <typename T>
+class vec {
+
+    thrust::device_vector<T> &_v;
+
+public:
+
+    explicit vec(thrust::device_vector<T> &v) : _v(v) {}
+
+    /// \brief Get the vector as a leaf of an expression tree
+    terminal<T> expr() const {
+        return terminal<T>(thrust::raw_pointer_cast(_v.data()), _v.size());
+    }
+
+    size_t size() const { return _v.size(); }
+
+    /// \brief Evaluate an expression into the vector in a single pass
+    /// \details The vector may appear in the expression, e.g. y = a*x + y,
+    ///          because every item is read before it is written.
+    template <typename E>
+    vec& operator=(const expression<E> &e);
+};
+
+
+/// \brief Check if a type can be an operand of an expression
+template <typename E>
+struct is_operand : std::is_base_of<expression<E>, E> {};
+
+template <typename T>
+struct is_operand<vec<T>> : std::true_type {};
+
+
+/// \brief Convert an operand to an expression
+template <typename E>
+const E& as_expr(const expression<E> &e) {
+    return static_cast<const E&>(e);
+}
+
+template <typename T>
+terminal<T> as_expr(const vec<T> &v) {
+    return v.expr();
+}
+
+
+///< Expression type of an operand
+template <typename E>
+using expr_t = typename std::decay<decltype(as_expr(std::declval<E>()))>::type;
+
+///< Enabled if all types are operands
+template <typename A, typename B = A>
+using if_operands =
+    typename std::enable_if<is_operand<A>::value && is_operand<B>::value>::type;
+
+
+template <typename A, typename B, typename = if_operands<A, B>>
+binary<expr_t<A>, expr_t<B>, thrust::plus<typename expr_t<A>::value_type>>
+operator+(const A &a, const B &b) {
+    return {as_expr(a), as_expr(b)};
+}
+
+template <typename A, typename B, typename = if_operands<A, B>>
+binary<expr_t<A>, expr_t<B>, thrust::minus<typename expr_t<A>::value_type>>
+operator-(const A &a, const B &b) {
+    return {as_expr(a), as_expr(b)};
+}
+
+template <typename E, typename = if_operands<E>>
+scaled<expr_t<E>> operator*(typename expr_t<E>::value_type a, const E &e) {
+    return {a, as_expr(e)};
+}
+
+
+/// \brief A functor for evaluating the i-th item of an expression
+template <typename E>
+struct item {
+
+    E e;
+
+    __host__ __device__
+    typename E::value_type operator()(size_t i) const {
+        return e[i];
+    }
+};
+
+
+/// \brief A functor for computing the square of the i-th item of an expression
+template <typename E>
+struct item_square {
+
+    E e;
+
+    __host__ __device__
+    typename E::value_type operator()(size_t i) const {
+        auto x = e[i];
+        return x * x;
+    }
+};
+
+
+/// \brief A functor for computing the i-th product of two expressions
+template <typename L, typename R>
+struct item_product {
+
+    L l;
+    R r;
+
+    __host__ __device__
+    typename L::value_type operator()(size_t i) const {
+        return l[i] * r[i];
+    }
+};
+
+
+template <typename T>
+template <typename E>
+vec<T>& vec<T>::operator=(const expression<E> &e) {
+
+    auto &x = as_expr(e);
+    if (x.size() != size())
+        throw std::invalid_argument("blas1: mismatched vector sizes");
+
+    thrust::transform(gpuutils::policy(),
+                      thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator<size_t>(size()),
+                      _v.begin(),
+                      item<E>{x});
+    return *this;
+}
+
+
+/// \brief Dot product of two operands in a single pass
+template <typename A, typename B, typename = if_operands<A, B>>
+typename expr_t<A>::value_type dot(const A &a, const B &b) {
+
+    using value_type = typename expr_t<A>::value_type;
+
+    auto l = as_expr(a);
+    auto r = as_expr(b);
+    if (l.size() != r.size())
+        throw std::invalid_argument("blas1: mismatched vector sizes");
+
+    return thrust::transform_reduce(
+                gpuutils::policy(),
+                thrust::make_counting_iterator<size_t>(0),
+                thrust::make_counting_iterator<size_t>(l.size()),
+                item_product<expr_t<A>, expr_t<B>>{l, r},
+                value_type(0),
+                thrust::plus<value_type>()
+           );
+}
+
+
+/// \brief Euclidean norm of an operand in a single pass
+template <typename E, typename = if_operands<E>>
+typename expr_t<E>::value_type nrm2(const E &e) {
+
+    using value_type = typename expr_t<E>::value_type;
+
+    auto x = as_expr(e);
+
+    return std::sqrt(
+            thrust::transform_reduce(
+                gpuutils::policy(),
+                thrust::make_counting_iterator<size_t>(0),
+                thrust::make_counting_iterator<size_t>(x.size()),
+                item_square<expr_t<E>>{x},
+                value_type(0),
+                thrust::plus<value_type>()
+            )
+           );
+}
+
+
+}   // namespace
+
+
+///----------------------------------------------------------------------------
+/// BLAS-1 chains, fused through blas1 expressions
+///----------------------------------------------------------------------------
+
+/// \brief Y = A * X + B * Y
+template <typename T>
+void run_axpby_fused(T A, thrust::device_vector<T> &X,
+                     T B, thrust::device_vector<T> &Y) {
+    blas1::vec<T> x(X), y(Y);
+    y = A * x + B * y;
+}
+
+
+/// \brief Traffic of run_axpby_fused, read X and Y, write Y
+template <typename T>
+benchutils::Traffic traffic_axpby_fused(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 2, 1, 3);
+}
+
+
+/// \brief W = A * X + B * Y
+template <typename T>
+void run_waxpby_fused(T A, thrust::device_vector<T> &X,
+                      T B, thrust::device_vector<T> &Y,
+                      thrust::device_vector<T> &W) {
+    blas1::vec<T> x(X), y(Y), w(W);
+    w = A * x + B * y;
+}
+
+
+/// \brief Traffic of run_waxpby_fused, read X and Y, write W
+template <typename T>
+benchutils::Traffic traffic_waxpby_fused(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 2, 1, 3);
+}
+
+
+/// \brief Y = A * X + B * Y + C * Z
+template <typename T>
+void run_axpbypcz_fused(T A, thrust::device_vector<T> &X,
+                        T B, thrust::device_vector<T> &Y,
+                        T C, thrust::device_vector<T> &Z) {
+    blas1::vec<T> x(X), y(Y), z(Z);
+    y = A * x + B * y + C * z;
+}
+
+
+/// \brief Traffic of run_axpbypcz_fused, read X, Y and Z, write Y
+template <typename T>
+benchutils::Traffic traffic_axpbypcz_fused(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 3, 1, 5);
+}
+
+
+/// \brief X . Y
+template <typename T>
+T run_dot_fused(thrust::device_vector<T> &X, thrust::device_vector<T> &Y) {
+    blas1::vec<T> x(X), y(Y);
+    return blas1::dot(x, y);
+}
+
+
+/// \brief Traffic of run_dot_fused, read X and Y
+template <typename T>
+benchutils::Traffic traffic_dot_fused(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 2, 0, 2);
+}
+
+
+/// \brief ||A * X - Y||
+template <typename T>
+T run_nrm2_fused(T A, thrust::device_vector<T> &X,
+                 thrust::device_vector<T> &Y) {
+    blas1::vec<T> x(X), y(Y);
+    return blas1::nrm2(A * x - y);
+}
+
+
+/// \brief Traffic of run_nrm2_fused, read X and Y
+template <typename T>
+benchutils::Traffic traffic_nrm2_fused(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 2, 0, 4);
+}
+
+
+///----------------------------------------------------------------------------
+/// BLAS-1 chains, one thrust call per operation
+///----------------------------------------------------------------------------
+
+/// \brief Y = A * X + B * Y
+template <typename T>
+void run_axpby_unfused(T A, thrust::device_vector<T> &X,
+                       T B, thrust::device_vector<T> &Y) {
+
+    gpuutils::temporary_vector<T> temp(X.size());
+
+    // temp = A * X
+    thrust::fill(gpuutils::policy(), temp.begin(), temp.end(), A);
+    thrust::transform(gpuutils::policy(),
+        X.begin(), X.end(), temp.begin(), temp.begin(),
+        thrust::multiplies<T>());
+
+    // Y = B * Y
+    thrust::transform(gpuutils::policy(),
+        Y.begin(), Y.end(), thrust::make_constant_iterator(B),
+        Y.begin(), thrust::multiplies<T>());
+
+    // Y = temp + Y
+    thrust::transform(gpuutils::policy(),
+        temp.begin(), temp.end(), Y.begin(), Y.begin(),
+        thrust::plus<T>());
+}
+
+
+/// \brief Traffic of run_axpby_unfused, a fill and three transforms
+template <typename T>
+benchutils::Traffic traffic_axpby_unfused(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 0, 1)         // fill
+         + benchutils::Traffic::items(n, sizeof(T), 2, 1, 1)      // temp = A * X
+         + benchutils::Traffic::items(n, sizeof(T), 1, 1, 1)      // Y = B * Y
+         + benchutils::Traffic::items(n, sizeof(T), 2, 1, 1);     // Y = temp + Y
+}
+
+
+/// \brief W = A * X + B * Y
+template <typename T>
+void run_waxpby_unfused(T A, thrust::device_vector<T> &X,
+                        T B, thrust::device_vector<T> &Y,
+                        thrust::device_vector<T> &W) {
+
+    gpuutils::temporary_vector<T> temp(X.size());
+
+    // temp = A * X
+    thrust::transform(gpuutils::policy(),
+        X.begin(), X.end(), thrust::make_constant_iterator(A),
+        temp.begin(), thrust::multiplies<T>());
+
+    // W = B * Y
+    thrust::transform(gpuutils::policy(),
+        Y.begin(), Y.end(), thrust::make_constant_iterator(B),
+        W.begin(), thrust::multiplies<T>());
+
+    // W = temp + W
+    thrust::transform(gpuutils::policy(),
+        temp.begin(), temp.end(), W.begin(), W.begin(),
+        thrust::plus<T>());
+}
+
+
+/// \brief Traffic of run_waxpby_unfused, three transforms
+template <typename T>
+benchutils::Traffic traffic_waxpby_unfused(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 1, 1)      // temp = A * X
+         + benchutils::Traffic::items(n, sizeof(T), 1, 1, 1)      // W = B * Y
+         + benchutils::Traffic::items(n, sizeof(T), 2, 1, 1);     // W = temp + W
+}
+
+
+/// \brief Y = A * X + B * Y + C * Z
+template <typename T>
+void run_axpbypcz_unfused(T A, thrust::device_vector<T> &X,
+                          T B, thrust::device_vector<T> &Y,
+                          T C, thrust::device_vector<T> &Z) {
+
+    gpuutils::temporary_vector<T> temp(X.size());
+
+    // Y = A * X + B * Y
+    run_axpby_unfused(A, X, B, Y);
+
+    // temp = C * Z
+    thrust::transform(gpuutils::policy(),
+        Z.begin(), Z.end(), thrust::make_constant_iterator(C),
+        temp.begin(), thrust::multiplies<T>());
+
+    // Y = Y + temp
+    thrust::transform(gpuutils::policy(),
+        Y.begin(), Y.end(), temp.begin(), Y.begin(),
+        thrust::plus<T>());
+}
+
+
+/// \brief Traffic of run_axpbypcz_unfused, run_axpby_unfused and two transforms
+template <typename T>
+benchutils::Traffic traffic_axpbypcz_unfused(size_t n) {
+    return traffic_axpby_unfused<T>(n)
+         + benchutils::Traffic::items(n, sizeof(T), 1, 1, 1)      // temp = C * Z
+         + benchutils::Traffic::items(n, sizeof(T), 2, 1, 1);     // Y = Y + temp
+}
+
+
+/// \brief X . Y
+template <typename T>
+T run_dot_unfused(thrust::device_vector<T> &X, thrust::device_vector<T> &Y) {
+
+    gpuutils::temporary_vector<T> temp(X.size());
+
+    // temp = X * Y
+    thrust::transform(gpuutils::policy(),
+        X.begin(), X.end(), Y.begin(), temp.begin(),
+        thrust::multiplies<T>());
+
+    return thrust::reduce(gpuutils::policy(),
+                          temp.begin(), temp.end(), T(0), thrust::plus<T>());
+}
+
+
+/// \brief Traffic of run_dot_unfused, a transform and a reduction
+template <typename T>
+benchutils::Traffic traffic_dot_unfused(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 2, 1, 1)      // temp = X * Y
+         + benchutils::Traffic::items(n, sizeof(T), 1, 0, 1);     // reduce
+}
+
+
+/// \brief ||A * X - Y||
+template <typename T>
+T run_nrm2_unfused(T A, thrust::device_vector<T> &X,
+                   thrust::device_vector<T> &Y) {
+
+    gpuutils::temporary_vector<T> temp(X.size());
+
+    // temp = A * X
+    thrust::transform(gpuutils::policy(),
+        X.begin(), X.end(), thrust::make_constant_iterator(A),
+        temp.begin(), thrust::multiplies<T>());
+
+    // temp = temp - Y
+    thrust::transform(gpuutils::policy(),
+        temp.begin(), temp.end(), Y.begin(), temp.begin(),
+        thrust::minus<T>());
+
+    // temp = temp * temp
+    thrust::transform(gpuutils::policy(),
+        temp.begin(), temp.end(), temp.begin(), temp.begin(),
+        thrust::multiplies<T>());
+
+    return std::sqrt(
+        thrust::reduce(gpuutils::policy(),
+                       temp.begin(), temp.end(), T(0), thrust::plus<T>()));
+}
+
+
+/// \brief Traffic of run_nrm2_unfused, three transforms and a reduction
+template <typename T>
+benchutils::Traffic traffic_nrm2_unfused(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 1, 1)      // temp = A * X
+         + benchutils::Traffic::items(n, sizeof(T), 2, 1, 1)      // temp = temp - Y
+         + benchutils::Traffic::items(n, sizeof(T), 2, 1, 1)      // temp = temp * temp
+         + benchutils::Traffic::items(n, sizeof(T), 1, 0, 1);     // reduce
+}
+
+
+#endif  // BENCHMARK_SAXPY_BLAS1_H_
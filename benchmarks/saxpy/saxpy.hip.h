@@ -1,20 +1,32 @@
 #ifndef BENCHMARK_SAXPY_H_
 #define BENCHMARK_SAXPY_H_
 
+#include <thrust/copy.h>
 #include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
 #include <thrust/fill.h>
 #include <thrust/functional.h>
+#include <thrust/host_vector.h>
 #include <thrust/sequence.h>
 #include <thrust/transform.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/tuple.h>
+#include <utility>
+
+#include "utils/allocators.h"    /* policy, temporary_vector */
+#include "utils/dispatch.h"      /* crossover */
+#include "utils/segments.h"      /* make_segment_id_iterator */
+#include "utils/traffic.h"       /* Traffic */
 
 
 /// \brief SAXPY using kernel fusion
-template <typename T>
-void run_saxpy_fast(T A, thrust::device_vector<T>& X,
-                         thrust::device_vector<T>& Y) {
+template <typename T, typename Alloc>
+void run_saxpy_fast(T A, thrust::device_vector<T, Alloc>& X,
+                         thrust::device_vector<T, Alloc>& Y) {
 
     // Y = A * X + Y
     thrust::transform(
+        gpuutils::policy(),
         X.begin(), X.end(),             // InputIterator1 begin, InputIterator1 end
         Y.begin(),                      // InputIterator2 begin
         Y.begin(),                      // OutputIterator result
@@ -25,23 +37,179 @@ void run_saxpy_fast(T A, thrust::device_vector<T>& X,
 }
 
 
-/// \brief SAXPY using multiple thrust::transform
+/// \brief Traffic of run_saxpy_fast, read X and Y, write Y
 template <typename T>
-void run_saxpy_slow(T A, thrust::device_vector<T>& X,
-                         thrust::device_vector<T>& Y) {
+benchutils::Traffic traffic_saxpy_fast(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 2, 1, 2);
+}
+
 
-    thrust::device_vector<T> temp(X.size());
+/// \brief SAXPY using multiple thrust::transform
+template <typename T, typename Alloc>
+void run_saxpy_slow(T A, thrust::device_vector<T, Alloc>& X,
+                         thrust::device_vector<T, Alloc>& Y) {
+
+    gpuutils::temporary_vector<T> temp(X.size());
 
     // temp = A
-    thrust::fill(temp.begin(), temp.end(), A);
+    thrust::fill(gpuutils::policy(), temp.begin(), temp.end(), A);
 
     // temp = A * X
-    thrust::transform(X.begin(), X.end(), temp.begin(), temp.begin(),
+    thrust::transform(gpuutils::policy(),
+        X.begin(), X.end(), temp.begin(), temp.begin(),
         thrust::multiplies<T>());
 
     // Y = A * X + Y
-    thrust::transform(temp.begin(), temp.end(), Y.begin(), Y.begin(),
+    thrust::transform(gpuutils::policy(),
+        temp.begin(), temp.end(), Y.begin(), Y.begin(),
         thrust::plus<T>());
 }
 
+
+/// \brief Traffic of run_saxpy_slow, a fill and two transforms
+template <typename T>
+benchutils::Traffic traffic_saxpy_slow(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 0, 1)        // fill
+         + benchutils::Traffic::items(n, sizeof(T), 2, 1, 1)     // temp = A * X
+         + benchutils::Traffic::items(n, sizeof(T), 2, 1, 1);    // Y = temp + Y
+}
+
+
+///----------------------------------------------------------------------------
+/// Generated inputs
+///----------------------------------------------------------------------------
+
+/// \brief SAXPY with X from an input iterator
+/// \details The iterator is a vector iterator, or a fancy iterator computing
+///          items from their index so that X is never stored.
+template <typename T, typename Iterator>
+void run_saxpy_input(T A, Iterator X, thrust::device_vector<T>& Y) {
+
+    // Y = A * X + Y
+    thrust::transform(
+        gpuutils::policy(),
+        X, X + Y.size(),                // InputIterator1 begin, InputIterator1 end
+        Y.begin(),                      // InputIterator2 begin
+        Y.begin(),                      // OutputIterator result
+        [=](const T &x, const T &y) {   // BinaryFunction op
+            return A * x + y;
+        }
+    );
+}
+
+
+/// \brief Traffic of run_saxpy_input for a generated X, read and write Y
+template <typename T>
+benchutils::Traffic traffic_saxpy_generated(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 1, 2);
+}
+
+
+///----------------------------------------------------------------------------
+/// Batched small problems
+///----------------------------------------------------------------------------
+
+/// \brief A functor for computing A[s] * x + y, s the segment of x
+template <typename T>
+struct segmented_axpy {
+
+    const T *A;
+
+    __host__ __device__
+    T operator()(const thrust::tuple<T, size_t> &x_s, const T &y) const {
+        return A[thrust::get<1>(x_s)] * thrust::get<0>(x_s) + y;
+    }
+};
+
+
+/// \brief Many SAXPYs stored in flat buffers, one thrust::transform
+/// \param A       Scalars, one per problem
+/// \param X       Items of X of all problems
+/// \param Y       Items of Y of all problems
+/// \param offsets Offsets of problems in X and Y, n_problems + 1 items
+template <typename T>
+void run_saxpy_batched(thrust::device_vector<T>& A,
+                       thrust::device_vector<T>& X,
+                       thrust::device_vector<T>& Y,
+                       thrust::device_vector<size_t>& offsets) {
+
+    auto x_s = thrust::make_zip_iterator(thrust::make_tuple(
+                    X.begin(), benchutils::make_segment_id_iterator(offsets)));
+
+    // Y = A[s] * X + Y
+    thrust::transform(
+        gpuutils::policy(),
+        x_s, x_s + X.size(),            // InputIterator1 begin, InputIterator1 end
+        Y.begin(),                      // InputIterator2 begin
+        Y.begin(),                      // OutputIterator result
+        segmented_axpy<T>{thrust::raw_pointer_cast(A.data())}
+    );
+}
+
+
+/// \brief Traffic of run_saxpy_batched, read X and Y, write Y, read A once
+template <typename T>
+benchutils::Traffic traffic_saxpy_batched(size_t n, size_t n_problems) {
+    return benchutils::Traffic::items(n, sizeof(T), 2, 1, 2)
+         + benchutils::Traffic::items(n_problems, sizeof(T), 1, 0);
+}
+
+
+///----------------------------------------------------------------------------
+/// Host/device dispatch
+///----------------------------------------------------------------------------
+
+/// \brief SAXPY on host vectors with the host system
+template <typename T>
+void host_saxpy(T A, const thrust::host_vector<T> &X,
+                     thrust::host_vector<T> &Y) {
+
+    thrust::transform(
+        thrust::host,
+        X.begin(), X.end(), Y.begin(), Y.begin(),
+        [=](const T &x, const T &y) {
+            return A * x + y;
+        }
+    );
+}
+
+
+/// \brief SAXPY on host vectors on device, copies included
+template <typename T>
+void device_saxpy(T A, const thrust::host_vector<T> &X,
+                       thrust::host_vector<T> &Y) {
+
+    thrust::device_vector<T> dev_X(X);
+    thrust::device_vector<T> dev_Y(Y);
+    run_saxpy_fast(A, dev_X, dev_Y);
+    thrust::copy(dev_Y.begin(), dev_Y.end(), Y.begin());
+}
+
+
+/// \brief Get the size from which dispatch_saxpy runs on device
+template <typename T>
+size_t saxpy_crossover() {
+    using pair_t = std::pair<thrust::host_vector<T>, thrust::host_vector<T>>;
+
+    static const size_t crossover = benchutils::crossover(
+        benchutils::tuningKey<T>("saxpy"),
+        [](size_t n) { return pair_t(thrust::host_vector<T>(n, T(1)),
+                                     thrust::host_vector<T>(n, T(1))); },
+        [](pair_t &XY) { host_saxpy(T(2), XY.first, XY.second); },
+        [](pair_t &XY) { device_saxpy(T(2), XY.first, XY.second); });
+
+    return crossover;
+}
+
+
+/// \brief SAXPY on host vectors on host below the crossover size
+template <typename T>
+void dispatch_saxpy(T A, const thrust::host_vector<T> &X,
+                         thrust::host_vector<T> &Y) {
+    if (X.size() < saxpy_crossover<T>())
+        host_saxpy(A, X, Y);
+    else
+        device_saxpy(A, X, Y);
+}
+
 #endif  // BENCHMARK_SAXPY_H_
@@ -1,5 +1,10 @@
 #include <benchmark/benchmark.h>
+#include <memory>
 
+#include "utils/cold_start.h"   /* COLD_START */
+#include "utils/counters.h"     /* allocator and traffic counters */
+#include "utils/inputs.h"       /* InputKind, withInput */
+#include "utils/timing.h"       /* IterationTimer */
 #include "scan.hip.h"
 
 
@@ -13,18 +18,21 @@ void bm_inclusive_scan(benchmark::State &state) {
     size_t N = state.range(0);
 
     // Allocate a device vector
-    thrust::device_vector<T> X(N<< 20);
+    gpuutils::tracked_vector<T> X(N<< 20);
 
     // Fill the vector
     thrust::sequence(X.begin(), X.end());
 
+    benchutils::resetAllocatorCounters();
+
+    benchutils::IterationTimer timer(state);
     for (auto _ : state) {
-        run_inclusive_scan(X);
-        hipDeviceSynchronize();
+        timer.time([&] { run_inclusive_scan(X); });
     }
 
-    state.SetBytesProcessed(int64_t(state.iterations())
-                            * int64_t(sizeof(T) * N << 20));
+    benchutils::setTrafficCounters(state, traffic_scan<T>(N << 20));
+    timer.setCounters();
+    benchutils::setAllocatorCounters(state, timer.batch());
 }
 
 
@@ -38,44 +46,147 @@ void bm_exclusive_scan(benchmark::State &state) {
     size_t N = state.range(0);
 
     // Allocate a device vector
-    thrust::device_vector<T> X(N<< 20);
+    gpuutils::tracked_vector<T> X(N<< 20);
 
     // Fill the vector.
     thrust::sequence(X.begin(), X.end());
 
+    benchutils::IterationTimer timer(state);
     for (auto _ : state) {
-        run_exclusive_scan(X);
-        hipDeviceSynchronize();
+        timer.time([&] { run_exclusive_scan(X); });
     }
 
-    state.SetBytesProcessed(int64_t(state.iterations())
-                            * int64_t(sizeof(T) * N << 20));
+    benchutils::setTrafficCounters(state, traffic_scan<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::inclusive_scan for 1K to 4M items, launch latency
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_inclusive_scan_latency(benchmark::State &state) {
+
+    // Number of items
+    size_t n = state.range(0);
+
+    // Allocate a device vector
+    gpuutils::tracked_vector<T> X(n, T(1));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_inclusive_scan(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_scan<T>(n));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::inclusive_scan for host vectors, dispatched to host or device
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_inclusive_scan_dispatch(benchmark::State &state) {
+
+    // Number of items
+    size_t n = state.range(0);
+
+    // Allocate a host vector
+    thrust::host_vector<T> X(n, T(1));
+
+    // Calibrate the crossover before timing, if needed
+    dispatch_inclusive_scan(X);
+
+    // Host calls are not seen by events
+    benchutils::IterationTimer timer(state, benchutils::options().timing_batch,
+                                     /* events */ false);
+    for (auto _ : state) {
+        timer.time([&] { dispatch_inclusive_scan(X); });
+    }
+
+    timer.setCounters();
+    state.SetLabel(n < inclusive_scan_crossover<T>() ? "host" : "device");
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::inclusive_scan of materialized or generated inputs
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_inclusive_scan_input(benchmark::State &state) {
+
+    // Number of items (million) and input kind
+    size_t N  = state.range(0);
+    auto kind = benchutils::InputKind(state.range(1));
+
+    // Allocate the output
+    thrust::device_vector<T> Y(N << 20);
+
+    // Only a materialized input is read from memory
+    auto traffic = kind == benchutils::InputKind::materialized
+                 ? traffic_scan<T>(N << 20)
+                 : traffic_scan_generated<T>(N << 20);
+
+    benchutils::withInput<T>(kind, N << 20, [&](auto X) {
+        benchutils::IterationTimer timer(state);
+        for (auto _ : state) {
+            timer.time([&] { run_inclusive_scan_input(X, Y); });
+        }
+
+        benchutils::setTrafficCounters(state, traffic);
+        timer.setCounters();
+    });
+
+    state.SetLabel(benchutils::inputKindName(kind));
 }
 
 
 /// Benchmark registration
 BENCHMARK_TEMPLATE(bm_inclusive_scan, float)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(4)
     ->Range(32, 1024);
 
 BENCHMARK_TEMPLATE(bm_inclusive_scan, double)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(4)
     ->Range(32, 512);
 
 BENCHMARK_TEMPLATE(bm_exclusive_scan, float)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(4)
     ->Range(32, 1024);
 
 BENCHMARK_TEMPLATE(bm_exclusive_scan, double)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(4)
     ->Range(32, 512);
 
+BENCHMARK_TEMPLATE(bm_inclusive_scan_latency, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(bm_inclusive_scan_dispatch, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(bm_inclusive_scan_input, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(benchutils::inputArguments);
+
 
+/// Cold-start registration, first calls on 1M items
+COLD_START("run_inclusive_scan<float>", [] {
+    auto X = std::make_shared<thrust::device_vector<float>>(1 << 20, 1.f);
+    return [X] { run_inclusive_scan(*X); };
+});
@@ -1,22 +1,102 @@
 #ifndef BENCHMARK_SCAN_H_
 #define BENCHMARK_SCAN_H_
 
+#include <thrust/copy.h>
 #include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
+#include <thrust/host_vector.h>
 #include <thrust/sequence.h>
 #include <thrust/scan.h>
 
+#include "utils/allocators.h"    /* policy */
+#include "utils/dispatch.h"      /* crossover */
+#include "utils/traffic.h"       /* Traffic */
+
 
 /// \brief Inclusively scan a vector on device
-template <typename T>
-void run_inclusive_scan(thrust::device_vector<T> &X) {
-    thrust::inclusive_scan(X.begin(), X.end(), X.begin());
+template <typename T, typename Alloc>
+void run_inclusive_scan(thrust::device_vector<T, Alloc> &X) {
+    thrust::inclusive_scan(gpuutils::policy(), X.begin(), X.end(), X.begin());
 }
 
 
 /// \brief Exclusively scan a vector on device
+template <typename T, typename Alloc>
+void run_exclusive_scan(thrust::device_vector<T, Alloc> &X) {
+    thrust::exclusive_scan(gpuutils::policy(), X.begin(), X.end(), X.begin());
+}
+
+/// \brief Traffic of an in-place scan, read and write X, one addition
+/// \details This is the minimum; the decoupled look-back of a single-pass
+///          scan adds little, a reduce-then-scan implementation reads X twice.
+template <typename T>
+benchutils::Traffic traffic_scan(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 1, 1);
+}
+
+
+///----------------------------------------------------------------------------
+/// Generated inputs
+///----------------------------------------------------------------------------
+
+/// \brief Inclusively scan Y.size() items of an input iterator into Y
+/// \details The iterator is a vector iterator, or a fancy iterator computing
+///          items from their index so that the input is never stored.
+template <typename T, typename Iterator>
+void run_inclusive_scan_input(Iterator first, thrust::device_vector<T> &Y) {
+    thrust::inclusive_scan(gpuutils::policy(),
+                           first, first + Y.size(), Y.begin());
+}
+
+
+/// \brief Traffic of run_inclusive_scan_input for a generated input,
+///        write Y
+template <typename T>
+benchutils::Traffic traffic_scan_generated(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 0, 1, 1);
+}
+
+
+///----------------------------------------------------------------------------
+/// Host/device dispatch
+///----------------------------------------------------------------------------
+
+/// \brief Inclusively scan a host vector with the host system
+template <typename T>
+void host_inclusive_scan(thrust::host_vector<T> &X) {
+    thrust::inclusive_scan(thrust::host, X.begin(), X.end(), X.begin());
+}
+
+
+/// \brief Inclusively scan a host vector on device, copies included
+template <typename T>
+void device_inclusive_scan(thrust::host_vector<T> &X) {
+    thrust::device_vector<T> dev_X(X);
+    run_inclusive_scan(dev_X);
+    thrust::copy(dev_X.begin(), dev_X.end(), X.begin());
+}
+
+
+/// \brief Get the size from which dispatch_inclusive_scan runs on device
+template <typename T>
+size_t inclusive_scan_crossover() {
+    static const size_t crossover = benchutils::crossover(
+        benchutils::tuningKey<T>("inclusive_scan"),
+        [](size_t n) { return thrust::host_vector<T>(n, T(1)); },
+        host_inclusive_scan<T>,
+        device_inclusive_scan<T>);
+
+    return crossover;
+}
+
+
+/// \brief Inclusively scan a host vector on host below the crossover size
 template <typename T>
-void run_exclusive_scan(thrust::device_vector<T> &X) {
-    thrust::exclusive_scan(X.begin(), X.end(), X.begin());
+void dispatch_inclusive_scan(thrust::host_vector<T> &X) {
+    if (X.size() < inclusive_scan_crossover<T>())
+        host_inclusive_scan(X);
+    else
+        device_inclusive_scan(X);
 }
 
 #endif  // BENCHMARK_SCAN_H_
@@ -0,0 +1,280 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+
+#include "utils/cold_start.h"   /* COLD_START */
+#include "utils/counters.h"     /* allocator and traffic counters */
+#include "utils/timing.h"       /* IterationTimer */
+#include "segmented.hip.h"
+
+
+/// \brief Set the number of segments and the longest one as counters
+void set_segment_counters(benchmark::State &state,
+                          const thrust::host_vector<size_t> &lengths) {
+    state.counters["segments"]   = lengths.size();
+    state.counters["max_length"] =
+        *std::max_element(lengths.begin(), lengths.end());
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::reduce_by_key with segment keys
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_reduce_by_key(benchmark::State &state) {
+
+    // Number of items (million) and distribution of segment lengths
+    size_t N  = state.range(0);
+    auto dist = SegmentLengths(state.range(1));
+
+    // Segment the items
+    auto lengths = make_segment_lengths(N << 20, dist);
+    thrust::device_vector<segment_key> keys = make_segment_keys(lengths);
+
+    // Allocate device vectors
+    thrust::device_vector<T> X(N << 20, T(1));
+    thrust::device_vector<segment_key> keys_out(lengths.size());
+    thrust::device_vector<T> sums(lengths.size());
+    size_t n_segments = 0;
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] {
+            n_segments = run_reduce_by_key(keys, X, keys_out, sums);
+        });
+    }
+
+    if (n_segments != lengths.size())
+        state.SkipWithError("Wrong number of segments");
+
+    benchutils::setTrafficCounters(
+        state, traffic_reduce_by_key<T>(N << 20, lengths.size()));
+    timer.setCounters();
+    set_segment_counters(state, lengths);
+    state.SetLabel(segment_lengths_name(dist));
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::reduce_by_key with head flags
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_reduce_by_flags(benchmark::State &state) {
+
+    // Number of items (million) and distribution of segment lengths
+    size_t N  = state.range(0);
+    auto dist = SegmentLengths(state.range(1));
+
+    // Segment the items
+    auto lengths = make_segment_lengths(N << 20, dist);
+    thrust::device_vector<segment_key> flags = make_head_flags(lengths);
+
+    // Allocate device vectors
+    thrust::device_vector<T> X(N << 20, T(1));
+    thrust::device_vector<segment_key> flags_out(lengths.size());
+    thrust::device_vector<T> sums(lengths.size());
+    size_t n_segments = 0;
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] {
+            n_segments = run_reduce_by_flags(flags, X, flags_out, sums);
+        });
+    }
+
+    if (n_segments != lengths.size())
+        state.SkipWithError("Wrong number of segments");
+
+    benchutils::setTrafficCounters(
+        state, traffic_reduce_by_key<T>(N << 20, lengths.size()));
+    timer.setCounters();
+    set_segment_counters(state, lengths);
+    state.SetLabel(segment_lengths_name(dist));
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::reduce per segment
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_reduce_looped(benchmark::State &state) {
+
+    // Number of items (million) and distribution of segment lengths
+    size_t N  = state.range(0);
+    auto dist = SegmentLengths(state.range(1));
+
+    // Segment the items
+    auto lengths = make_segment_lengths(N << 20, dist);
+    auto offsets = benchutils::make_offsets(lengths);
+
+    // Allocate device vectors
+    thrust::device_vector<T> X(N << 20, T(1));
+    thrust::host_vector<T> sums(lengths.size());
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_reduce_looped(X, offsets, sums); });
+    }
+
+    benchutils::setTrafficCounters(
+        state, traffic_reduce_looped<T>(N << 20, lengths.size()));
+    timer.setCounters();
+    set_segment_counters(state, lengths);
+    state.SetLabel(segment_lengths_name(dist));
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::inclusive_scan_by_key with segment keys
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_inclusive_scan_by_key(benchmark::State &state) {
+
+    // Number of items (million) and distribution of segment lengths
+    size_t N  = state.range(0);
+    auto dist = SegmentLengths(state.range(1));
+
+    // Segment the items
+    auto lengths = make_segment_lengths(N << 20, dist);
+    thrust::device_vector<segment_key> keys = make_segment_keys(lengths);
+
+    // Allocate device vectors
+    thrust::device_vector<T> X(N << 20, T(1));
+    thrust::device_vector<T> Y(N << 20);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_inclusive_scan_by_key(keys, X, Y); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_scan_by_key<T>(N << 20));
+    timer.setCounters();
+    set_segment_counters(state, lengths);
+    state.SetLabel(segment_lengths_name(dist));
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::inclusive_scan_by_key with head flags
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_inclusive_scan_by_flags(benchmark::State &state) {
+
+    // Number of items (million) and distribution of segment lengths
+    size_t N  = state.range(0);
+    auto dist = SegmentLengths(state.range(1));
+
+    // Segment the items
+    auto lengths = make_segment_lengths(N << 20, dist);
+    thrust::device_vector<segment_key> flags = make_head_flags(lengths);
+
+    // Allocate device vectors
+    thrust::device_vector<T> X(N << 20, T(1));
+    thrust::device_vector<T> Y(N << 20);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_inclusive_scan_by_flags(flags, X, Y); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_scan_by_key<T>(N << 20));
+    timer.setCounters();
+    set_segment_counters(state, lengths);
+    state.SetLabel(segment_lengths_name(dist));
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::inclusive_scan per segment
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_inclusive_scan_looped(benchmark::State &state) {
+
+    // Number of items (million) and distribution of segment lengths
+    size_t N  = state.range(0);
+    auto dist = SegmentLengths(state.range(1));
+
+    // Segment the items
+    auto lengths = make_segment_lengths(N << 20, dist);
+    auto offsets = benchutils::make_offsets(lengths);
+
+    // Allocate device vectors
+    thrust::device_vector<T> X(N << 20, T(1));
+    thrust::device_vector<T> Y(N << 20);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_inclusive_scan_looped(X, offsets, Y); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_scan_looped<T>(N << 20));
+    timer.setCounters();
+    set_segment_counters(state, lengths);
+    state.SetLabel(segment_lengths_name(dist));
+}
+
+
+/// \brief Arguments (million items, distribution) for one launch per batch
+void segmented_arguments(benchmark::internal::Benchmark *b) {
+    for (int dist = 0; dist < n_segment_lengths; ++dist)
+        for (int N = 1; N <= 64; N *= 4)
+            b->Args({N, dist});
+}
+
+
+/// \brief Arguments (million items, distribution) for one call per segment
+/// \details Tiny segments make about 400K calls per million items, so
+///          sizes are kept small.
+void looped_arguments(benchmark::internal::Benchmark *b) {
+    for (int dist = 0; dist < n_segment_lengths; ++dist)
+        b->Args({1, dist});
+}
+
+
+/// Benchmark registration
+BENCHMARK_TEMPLATE(bm_reduce_by_key, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(segmented_arguments);
+
+BENCHMARK_TEMPLATE(bm_reduce_by_flags, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(segmented_arguments);
+
+BENCHMARK_TEMPLATE(bm_reduce_looped, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(looped_arguments);
+
+BENCHMARK_TEMPLATE(bm_inclusive_scan_by_key, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(segmented_arguments);
+
+BENCHMARK_TEMPLATE(bm_inclusive_scan_by_flags, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(segmented_arguments);
+
+BENCHMARK_TEMPLATE(bm_inclusive_scan_looped, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(looped_arguments);
+
+
+/// Cold-start registration, first calls on 1M items
+COLD_START("run_reduce_by_key<float>", [] {
+    auto lengths  = make_segment_lengths(1 << 20, SegmentLengths::uniform);
+    auto keys     = std::make_shared<thrust::device_vector<segment_key>>(
+                        make_segment_keys(lengths));
+    auto X        = std::make_shared<thrust::device_vector<float>>(
+                        1 << 20, 1.f);
+    auto keys_out = std::make_shared<thrust::device_vector<segment_key>>(
+                        lengths.size());
+    auto sums     = std::make_shared<thrust::device_vector<float>>(
+                        lengths.size());
+    return [keys, X, keys_out, sums] {
+        run_reduce_by_key(*keys, *X, *keys_out, *sums);
+    };
+});
@@ -0,0 +1,244 @@
+#ifndef BENCHMARK_SEGMENTED_H_
+#define BENCHMARK_SEGMENTED_H_
+
+#include <thrust/device_vector.h>
+#include <thrust/host_vector.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "utils/allocators.h"    /* policy */
+#include "utils/segments.h"      /* make_offsets */
+#include "utils/traffic.h"       /* Traffic */
+
+
+///< Type of segment keys and head flags
+using segment_key = int32_t;
+
+
+///----------------------------------------------------------------------------
+/// Segment lengths
+///----------------------------------------------------------------------------
+
+/// \brief Distributions of segment lengths
+enum class SegmentLengths : int {
+    uniform = 0,        ///< Uniform in [1, 2047], 1024 on average
+    power_law,          ///< Pareto with exponent 1.1, mostly short, a few huge
+    tiny                ///< Uniform in [1, 4]
+};
+
+///< Number of distributions of segment lengths
+constexpr int n_segment_lengths = 3;
+
+
+/// \brief Get the name of a distribution of segment lengths
+inline const char* segment_lengths_name(SegmentLengths dist) {
+    switch (dist) {
+        case SegmentLengths::uniform:   return "uniform";
+        case SegmentLengths::power_law: return "power_law";
+        case SegmentLengths::tiny:      return "tiny";
+    }
+    return "unknown";
+}
+
+
+/// \brief Draw random segment lengths covering exactly n items
+/// \details The last segment is cut to fit, and so are power-law lengths
+///          longer than what is left.
+inline thrust::host_vector<size_t>
+make_segment_lengths(size_t n, SegmentLengths dist, uint64_t seed = 42) {
+
+    std::mt19937_64 engine(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    thrust::host_vector<size_t> lengths;
+    for (size_t total = 0; total < n; ) {
+        size_t length;
+        switch (dist) {
+            case SegmentLengths::uniform:
+                length = 1 + size_t(unit(engine) * 2047);
+                break;
+            case SegmentLengths::power_law:
+                length = size_t(std::min(
+                    std::pow(1.0 - unit(engine), -1.0 / 1.1), double(n)));
+                break;
+            default:
+                length = 1 + size_t(unit(engine) * 4);
+        }
+
+        length = std::min(length, n - total);
+        lengths.push_back(length);
+        total += length;
+    }
+
+    return lengths;
+}
+
+
+/// \brief Make segment keys, item i holds the id of its segment
+inline thrust::host_vector<segment_key>
+make_segment_keys(const thrust::host_vector<size_t> &lengths) {
+
+    thrust::host_vector<segment_key> keys;
+    for (size_t s = 0; s < lengths.size(); ++s)
+        keys.insert(keys.end(), lengths[s], segment_key(s));
+    return keys;
+}
+
+
+/// \brief Make head flags, 1 for the first item of a segment, 0 otherwise
+inline thrust::host_vector<segment_key>
+make_head_flags(const thrust::host_vector<size_t> &lengths) {
+
+    thrust::host_vector<segment_key> flags;
+    for (auto length : lengths) {
+        flags.push_back(1);
+        flags.insert(flags.end(), length - 1, 0);
+    }
+    return flags;
+}
+
+
+///----------------------------------------------------------------------------
+/// Key-based segmentation
+///----------------------------------------------------------------------------
+
+/// \brief Sum up values of segments given by keys
+/// \return Number of segments
+template <typename T>
+size_t run_reduce_by_key(thrust::device_vector<segment_key> &keys,
+                         thrust::device_vector<T> &X,
+                         thrust::device_vector<segment_key> &keys_out,
+                         thrust::device_vector<T> &sums) {
+    auto ends = thrust::reduce_by_key(gpuutils::policy(),
+                                      keys.begin(), keys.end(), X.begin(),
+                                      keys_out.begin(), sums.begin());
+    return ends.first - keys_out.begin();
+}
+
+
+/// \brief Inclusively scan values of segments given by keys
+template <typename T>
+void run_inclusive_scan_by_key(thrust::device_vector<segment_key> &keys,
+                               thrust::device_vector<T> &X,
+                               thrust::device_vector<T> &Y) {
+    thrust::inclusive_scan_by_key(gpuutils::policy(),
+                                  keys.begin(), keys.end(),
+                                  X.begin(), Y.begin());
+}
+
+
+///----------------------------------------------------------------------------
+/// Head-flag segmentation
+///----------------------------------------------------------------------------
+
+/// \brief A predicate for head flags, f(previous, flag) -> no head
+/// \details Consecutive items are in the same segment unless the second
+///          one is flagged, so any flag type of any value works.
+struct not_head {
+    __host__ __device__
+    bool operator()(segment_key, segment_key flag) const {
+        return flag == 0;
+    }
+};
+
+
+/// \brief Sum up values of segments given by head flags
+/// \return Number of segments
+template <typename T>
+size_t run_reduce_by_flags(thrust::device_vector<segment_key> &flags,
+                           thrust::device_vector<T> &X,
+                           thrust::device_vector<segment_key> &flags_out,
+                           thrust::device_vector<T> &sums) {
+    auto ends = thrust::reduce_by_key(gpuutils::policy(),
+                                      flags.begin(), flags.end(), X.begin(),
+                                      flags_out.begin(), sums.begin(),
+                                      not_head());
+    return ends.first - flags_out.begin();
+}
+
+
+/// \brief Inclusively scan values of segments given by head flags
+template <typename T>
+void run_inclusive_scan_by_flags(thrust::device_vector<segment_key> &flags,
+                                 thrust::device_vector<T> &X,
+                                 thrust::device_vector<T> &Y) {
+    thrust::inclusive_scan_by_key(gpuutils::policy(),
+                                  flags.begin(), flags.end(),
+                                  X.begin(), Y.begin(), not_head());
+}
+
+
+/// \brief Traffic of a reduction by key, read keys and X, write one key
+///        and one sum per segment, one addition per item
+template <typename T>
+benchutils::Traffic traffic_reduce_by_key(size_t n, size_t n_segments) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 0, 1)
+         + benchutils::Traffic::items(n, sizeof(segment_key), 1, 0)
+         + benchutils::Traffic::items(n_segments,
+                                      sizeof(T) + sizeof(segment_key), 0, 1);
+}
+
+
+/// \brief Traffic of a scan by key, read keys and X, write Y,
+///        one addition per item
+template <typename T>
+benchutils::Traffic traffic_scan_by_key(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 1, 1)
+         + benchutils::Traffic::items(n, sizeof(segment_key), 1, 0);
+}
+
+
+///----------------------------------------------------------------------------
+/// One call per segment
+///----------------------------------------------------------------------------
+
+/// \brief Sum up values of segments with one reduction per segment
+/// \param offsets Offsets of segments on host, n_segments + 1 items
+/// \param sums    Sums of segments on host, each returned by its call
+template <typename T>
+void run_reduce_looped(thrust::device_vector<T> &X,
+                       const thrust::host_vector<size_t> &offsets,
+                       thrust::host_vector<T> &sums) {
+    for (size_t s = 0; s + 1 < offsets.size(); ++s)
+        sums[s] = thrust::reduce(gpuutils::policy(),
+                                 X.begin() + offsets[s],
+                                 X.begin() + offsets[s + 1]);
+}
+
+
+/// \brief Inclusively scan values of segments with one scan per segment
+/// \param offsets Offsets of segments on host, n_segments + 1 items
+template <typename T>
+void run_inclusive_scan_looped(thrust::device_vector<T> &X,
+                               const thrust::host_vector<size_t> &offsets,
+                               thrust::device_vector<T> &Y) {
+    for (size_t s = 0; s + 1 < offsets.size(); ++s)
+        thrust::inclusive_scan(gpuutils::policy(),
+                               X.begin() + offsets[s],
+                               X.begin() + offsets[s + 1],
+                               Y.begin() + offsets[s]);
+}
+
+
+/// \brief Traffic of reductions of all segments, read X, one addition
+///        per item
+template <typename T>
+benchutils::Traffic traffic_reduce_looped(size_t n, size_t n_segments) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 0, 1)
+         + benchutils::Traffic::items(n_segments, sizeof(T), 0, 1);
+}
+
+
+/// \brief Traffic of scans of all segments, read X, write Y, one addition
+///        per item
+template <typename T>
+benchutils::Traffic traffic_scan_looped(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 1, 1);
+}
+
+#endif  // BENCHMARK_SEGMENTED_H_
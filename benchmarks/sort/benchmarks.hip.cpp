@@ -1,6 +1,17 @@
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
 
+#include "utils/cold_start.h"   /* COLD_START */
+#include "utils/counters.h"     /* allocator and traffic counters */
+#include "utils/gpu_utils.h"    /* deviceSynchronize */
+#include "utils/timing.h"       /* IterationTimer */
 #include "sort.hip.h"
+#include "keys.hip.h"
+#include "topk.hip.h"
+#include "external.hip.h"
 
 
 ///----------------------------------------------------------------------------
@@ -12,27 +23,594 @@ void bm_sort(benchmark::State &state) {
     // Number of items (million)
     size_t N = state.range(0);
 
-    // Allocate a device vector
+    // Generate random numbers once, restore them before each iteration
+    thrust::device_vector<T> input(N << 20);
+    gpuutils::tracked_vector<T> X(N << 20);
+    generate_keys(input, KeyDistribution::uniform);
+
+    benchutils::resetAllocatorCounters();
+
+    benchutils::IterationTimer timer(state, 1);
+    for (auto _ : state) {
+        thrust::copy(input.begin(), input.end(), X.begin());
+        gpuutils::deviceSynchronize();
+
+        timer.time([&] { run_sort(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sort<T>(N << 20));
+    timer.setCounters();
+    benchutils::setAllocatorCounters(state, timer.batch());
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::sort for keys from a distribution
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_sort_keys(benchmark::State &state) {
+
+    // Number of items (million) and key distribution
+    size_t N  = state.range(0);
+    auto dist = KeyDistribution(state.range(1));
+
+    // Generate the input once, restore it before each iteration
+    thrust::device_vector<T> input(N << 20);
+    gpuutils::tracked_vector<T> X(N << 20);
+    generate_keys(input, dist);
+
+    benchutils::IterationTimer timer(state, 1);
+    for (auto _ : state) {
+        thrust::copy(input.begin(), input.end(), X.begin());
+        gpuutils::deviceSynchronize();
+
+        timer.time([&] { run_sort_keys(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sort<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel(key_distribution_name(dist));
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::stable_sort for keys from a distribution
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_stable_sort(benchmark::State &state) {
+
+    // Number of items (million) and key distribution
+    size_t N  = state.range(0);
+    auto dist = KeyDistribution(state.range(1));
+
+    // Generate the input once, restore it before each iteration
+    thrust::device_vector<T> input(N << 20);
+    gpuutils::tracked_vector<T> X(N << 20);
+    generate_keys(input, dist);
+
+    benchutils::IterationTimer timer(state, 1);
+    for (auto _ : state) {
+        thrust::copy(input.begin(), input.end(), X.begin());
+        gpuutils::deviceSynchronize();
+
+        timer.time([&] { run_stable_sort(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sort<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel(key_distribution_name(dist));
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::sort_by_key for keys from a distribution
+///----------------------------------------------------------------------------
+template <typename K, typename V>
+void bm_sort_by_key(benchmark::State &state) {
+
+    // Number of items (million) and key distribution
+    size_t N  = state.range(0);
+    auto dist = KeyDistribution(state.range(1));
+
+    // Generate the keys once, restore them before each iteration.
+    // Values are permuted but never inspected, so they are not restored.
+    thrust::device_vector<K> input(N << 20);
+    gpuutils::tracked_vector<K> keys(N << 20);
+    gpuutils::tracked_vector<V> values(N << 20);
+    generate_keys(input, dist);
+
+    benchutils::IterationTimer timer(state, 1);
+    for (auto _ : state) {
+        thrust::copy(input.begin(), input.end(), keys.begin());
+        gpuutils::deviceSynchronize();
+
+        timer.time([&] { run_sort_by_key(keys, values); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sort_by_key<K, V>(N << 20));
+    timer.setCounters();
+    state.SetLabel(key_distribution_name(dist));
+}
+
+
+///----------------------------------------------------------------------------
+/// Descending sort with thrust::greater
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_sort_descending_comparator(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Generate the input once, restore it before each iteration
+    thrust::device_vector<T> input(N << 20);
+    gpuutils::tracked_vector<T> X(N << 20);
+    generate_keys(input, KeyDistribution::uniform);
+
+    benchutils::IterationTimer timer(state, 1);
+    for (auto _ : state) {
+        thrust::copy(input.begin(), input.end(), X.begin());
+        gpuutils::deviceSynchronize();
+
+        timer.time([&] { run_sort(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sort<T>(N << 20));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Descending sort with flipped keys and the default comparator
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_sort_descending_radix(benchmark::State &state) {
+
+    // Number of items (million)
+    size_t N = state.range(0);
+
+    // Generate the input once, restore it before each iteration
+    thrust::device_vector<T> input(N << 20);
+    gpuutils::tracked_vector<T> X(N << 20);
+    generate_keys(input, KeyDistribution::uniform);
+
+    benchutils::IterationTimer timer(state, 1);
+    for (auto _ : state) {
+        thrust::copy(input.begin(), input.end(), X.begin());
+        gpuutils::deviceSynchronize();
+
+        timer.time([&] { run_sort_descending(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sort_descending<T>(N << 20));
+    timer.setCounters();
+}
+
+
+/// \brief A 16-byte payload for key-value sorts
+struct payload16 {
+    uint64_t lo;
+    uint64_t hi;
+};
+
+
+/// \brief Arguments (million items, distribution) for sorting keys
+void sort_keys_arguments(benchmark::internal::Benchmark *b) {
+    for (int dist = 0; dist < n_key_distributions; ++dist)
+        for (int N = 4; N <= 256; N *= 4)
+            b->Args({N, dist});
+}
+
+
+/// \brief Arguments (million items, distribution) for sorting pairs
+void sort_pairs_arguments(benchmark::internal::Benchmark *b) {
+    for (int dist = 0; dist < n_key_distributions; ++dist)
+        for (int N = 4; N <= 64; N *= 4)
+            b->Args({N, dist});
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::sort for 1K to 4M keys, launch latency
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_sort_keys_latency(benchmark::State &state) {
+
+    // Number of keys
+    size_t n = state.range(0);
+
+    // Generate the input once, restore it before each iteration
+    thrust::device_vector<T> input(n);
+    gpuutils::tracked_vector<T> X(n);
+    generate_keys(input, KeyDistribution::uniform);
+
+    benchutils::IterationTimer timer(state, 1);
+    for (auto _ : state) {
+        thrust::copy(input.begin(), input.end(), X.begin());
+        gpuutils::deviceSynchronize();
+
+        timer.time([&] { run_sort_keys(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sort<T>(n));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::sort for host vectors, dispatched to host or device
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_sort_keys_dispatch(benchmark::State &state) {
+
+    // Number of keys
+    size_t n = state.range(0);
+
+    // Generate the input once, restore it before each iteration
+    thrust::device_vector<T> dev_input(n);
+    generate_keys(dev_input, KeyDistribution::uniform);
+    thrust::host_vector<T> input(dev_input);
+    thrust::host_vector<T> X(input);
+
+    // Calibrate the crossover before timing, if needed
+    dispatch_sort_keys(X);
+
+    // Host calls are not seen by events
+    benchutils::IterationTimer timer(state, 1, /* events */ false);
+    for (auto _ : state) {
+        thrust::copy(input.begin(), input.end(), X.begin());
+
+        timer.time([&] { dispatch_sort_keys(X); });
+    }
+
+    timer.setCounters();
+    state.SetLabel(n < sort_keys_crossover<T>() ? "host" : "device");
+}
+
+
+/// \brief Get k = n / 10^e, one at least
+size_t top_k_count(size_t n, int64_t e) {
+    return std::max<size_t>(1, size_t(n / std::pow(10., double(e))));
+}
+
+
+///----------------------------------------------------------------------------
+/// Top k of N keys, sampled threshold and copy_if
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_top_k(benchmark::State &state) {
+
+    // Number of keys (million) and k = N / 10^e
+    size_t N = state.range(0);
+    size_t k = top_k_count(N << 20, state.range(1));
+
+    // Uniform keys, not modified
     thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> top(k);
+    generate_keys(X, KeyDistribution::uniform);
 
-    // Generate a sequence
-    thrust::sequence(X.begin(), X.end());
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_top_k(X, top); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_top_k<T>(N << 20, k));
+    timer.setCounters();
+    state.counters["k"] = double(k);
+    state.SetLabel("k/N=1e-" + std::to_string(state.range(1)));
+}
+
+
+///----------------------------------------------------------------------------
+/// Top k of N keys, run_sort of a copy then truncate
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_top_k_by_sort(benchmark::State &state) {
 
+    // Number of keys (million) and k = N / 10^e
+    size_t N = state.range(0);
+    size_t k = top_k_count(N << 20, state.range(1));
+
+    // Uniform keys, copied to the work buffer before sorting
+    thrust::device_vector<T> X(N << 20);
+    thrust::device_vector<T> work(N << 20);
+    thrust::device_vector<T> top(k);
+    generate_keys(X, KeyDistribution::uniform);
+
+    benchutils::IterationTimer timer(state);
     for (auto _ : state) {
-        run_sort(X);
-        hipDeviceSynchronize();
+        timer.time([&] { run_top_k_by_sort(X, work, top); });
     }
 
-    state.SetBytesProcessed(int64_t(state.iterations())
-                            * int64_t(sizeof(T) * N << 20));
+    benchutils::setTrafficCounters(state,
+                                   traffic_top_k_by_sort<T>(N << 20, k));
+    timer.setCounters();
+    state.counters["k"] = double(k);
+    state.SetLabel("k/N=1e-" + std::to_string(state.range(1)));
+}
+
+
+///----------------------------------------------------------------------------
+/// Pairs of the top k of N keys, sampled threshold and copy_if
+///----------------------------------------------------------------------------
+template <typename K, typename V>
+void bm_top_k_by_key(benchmark::State &state) {
+
+    // Number of pairs (million) and k = N / 10^e
+    size_t N = state.range(0);
+    size_t k = top_k_count(N << 20, state.range(1));
+
+    // Uniform keys and values, not modified
+    thrust::device_vector<K> keys(N << 20);
+    thrust::device_vector<V> values(N << 20);
+    thrust::device_vector<K> top_keys(k);
+    thrust::device_vector<V> top_values(k);
+    generate_keys(keys, KeyDistribution::uniform);
+    thrust::sequence(values.begin(), values.end());
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] {
+            run_top_k_by_key(keys, values, top_keys, top_values);
+        });
+    }
+
+    benchutils::setTrafficCounters(state,
+                                   traffic_top_k_by_key<K, V>(N << 20, k));
+    timer.setCounters();
+    state.counters["k"] = double(k);
+    state.SetLabel("k/N=1e-" + std::to_string(state.range(1)));
+}
+
+
+///----------------------------------------------------------------------------
+/// Pairs of the top k of N keys, sort of copies then truncate
+///----------------------------------------------------------------------------
+template <typename K, typename V>
+void bm_top_k_by_key_by_sort(benchmark::State &state) {
+
+    // Number of pairs (million) and k = N / 10^e
+    size_t N = state.range(0);
+    size_t k = top_k_count(N << 20, state.range(1));
+
+    // Uniform keys and values, copied to work buffers before sorting
+    thrust::device_vector<K> keys(N << 20), work_keys(N << 20);
+    thrust::device_vector<V> values(N << 20), work_values(N << 20);
+    thrust::device_vector<K> top_keys(k);
+    thrust::device_vector<V> top_values(k);
+    generate_keys(keys, KeyDistribution::uniform);
+    thrust::sequence(values.begin(), values.end());
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] {
+            run_top_k_by_key_by_sort(keys, values, work_keys, work_values,
+                                     top_keys, top_values);
+        });
+    }
+
+    benchutils::setTrafficCounters(
+        state, traffic_top_k_by_key_by_sort<K, V>(N << 20, k));
+    timer.setCounters();
+    state.counters["k"] = double(k);
+    state.SetLabel("k/N=1e-" + std::to_string(state.range(1)));
+}
+
+
+/// \brief Arguments (million keys, e) for k / N = 10^-e, 1e-6 to 0.1
+void top_k_arguments(benchmark::internal::Benchmark *b) {
+    for (int N = 16; N <= 256; N *= 16)
+        for (int e = 6; e >= 1; --e)
+            b->Args({N, e});
+}
+
+
+///----------------------------------------------------------------------------
+/// Sort of 1x to 10x the device memory given to the sorter, run by run
+///----------------------------------------------------------------------------
+template <typename T>
+void bm_external_sort(benchmark::State &state) {
+
+    // Device memory of the sorter (MiB) and input size as a multiple of it
+    size_t budget   = size_t(state.range(0)) << 20;
+    size_t multiple = state.range(1);
+    size_t n        = multiple * budget / sizeof(T);
+
+    // Uniform keys on host, sorted into another host vector
+    thrust::host_vector<T> X(n);
+    thrust::host_vector<T> Y(n);
+    benchutils::generate(X, benchutils::DataSpec());
+
+    ExternalSorter<T> sorter(ExternalSorter<T>::runItems(budget, 2), 2);
+
+    // Runs are sorted on pipeline streams, merged on host
+    benchutils::PhaseTimer timer(state);
+    for (auto _ : state) {
+        timer.time("runs", [&] { sorter.sortRuns(X.begin(), X.end()); });
+        timer.time("merge", [&] { sorter.merge(Y.begin()); });
+        timer.endIteration();
+    }
+
+    benchutils::setTrafficCounters(state, traffic_external_sort<T>(n));
+    timer.setCounters();
+    state.counters["runs"] = double(sorter.runs());
+    state.SetLabel(std::to_string(multiple) + "x device memory");
+}
+
+
+/// \brief Arguments (device MiB, input multiple) for external sorts
+void external_sort_arguments(benchmark::internal::Benchmark *b) {
+    for (int multiple : {1, 2, 4, 10})
+        b->Args({256, multiple});
 }
 
 
 /// Benchmark registration
 BENCHMARK_TEMPLATE(bm_sort, int)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(4)
     ->Range(32, 1024);
 
+BENCHMARK_TEMPLATE(bm_sort_keys, int32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_keys_arguments);
+
+BENCHMARK_TEMPLATE(bm_sort_keys, int64_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_keys_arguments);
+
+BENCHMARK_TEMPLATE(bm_sort_keys, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_keys_arguments);
+
+BENCHMARK_TEMPLATE(bm_sort_keys, double)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_keys_arguments);
+
+BENCHMARK_TEMPLATE(bm_stable_sort, int32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_keys_arguments);
+
+BENCHMARK_TEMPLATE(bm_stable_sort, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_keys_arguments);
+
+BENCHMARK_TEMPLATE(bm_sort_by_key, int32_t, uint32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_pairs_arguments);
+
+BENCHMARK_TEMPLATE(bm_sort_by_key, int32_t, uint64_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_pairs_arguments);
+
+BENCHMARK_TEMPLATE(bm_sort_by_key, int32_t, payload16)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_pairs_arguments);
+
+BENCHMARK_TEMPLATE(bm_sort_by_key, int64_t, uint64_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_pairs_arguments);
+
+BENCHMARK_TEMPLATE(bm_sort_by_key, float, uint32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(sort_pairs_arguments);
+
+BENCHMARK_TEMPLATE(bm_sort_descending_comparator, int32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+BENCHMARK_TEMPLATE(bm_sort_descending_radix, int32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+BENCHMARK_TEMPLATE(bm_sort_descending_comparator, int64_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+BENCHMARK_TEMPLATE(bm_sort_descending_radix, int64_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+BENCHMARK_TEMPLATE(bm_sort_descending_comparator, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+BENCHMARK_TEMPLATE(bm_sort_descending_radix, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+BENCHMARK_TEMPLATE(bm_sort_descending_comparator, double)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+BENCHMARK_TEMPLATE(bm_sort_descending_radix, double)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+BENCHMARK_TEMPLATE(bm_sort_keys_latency, int32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(bm_sort_keys_dispatch, int32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(bm_top_k, int32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(top_k_arguments);
+
+BENCHMARK_TEMPLATE(bm_top_k_by_sort, int32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(top_k_arguments);
+
+BENCHMARK_TEMPLATE(bm_top_k, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(top_k_arguments);
+
+BENCHMARK_TEMPLATE(bm_top_k_by_sort, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(top_k_arguments);
+
+BENCHMARK_TEMPLATE(bm_top_k_by_key, float, uint32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(top_k_arguments);
+
+BENCHMARK_TEMPLATE(bm_top_k_by_key_by_sort, float, uint32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(top_k_arguments);
+
+BENCHMARK_TEMPLATE(bm_external_sort, int32_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(external_sort_arguments);
+
+BENCHMARK_TEMPLATE(bm_external_sort, int64_t)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(external_sort_arguments);
+
 
+/// Cold-start registration, first calls on 1M items
+COLD_START("run_sort<int32_t>", [] {
+    auto X = std::make_shared<thrust::device_vector<int32_t>>(1 << 20);
+    generate_keys(*X, KeyDistribution::uniform);
+    return [X] { run_sort(*X); };
+});
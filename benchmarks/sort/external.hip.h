@@ -0,0 +1,307 @@
+#ifndef BENCHMARK_EXTERNAL_H_
+#define BENCHMARK_EXTERNAL_H_
+
+#include <thrust/copy.h>
+#include <thrust/device_vector.h>
+#include <thrust/host_vector.h>
+#include <thrust/sort.h>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sort.hip.h"   /* traffic_sort */
+
+#include "utils/allocators.h"    /* policy, temporaryAllocator */
+#include "utils/gpu_utils.h"     /* pipelineStream */
+#include "utils/host_memory.h"   /* HostBuffer */
+#include "utils/traffic.h"       /* Traffic */
+
+
+///-----------------------------------------------------------------------------
+/// \class ExternalSorter
+/// \brief Sort host data of any size on device, run by run, and merge the
+///        runs on host
+/// \details Input is split into runs of a fixed number of keys. With B
+///          buffers, run j is staged in pinned buffer j % B and uploaded on
+///          pipeline stream j % B before run j - 1 is sorted and downloaded
+///          on its own stream. The sort returns once done, so the upload of
+///          run j overlaps with the sort of run j - 1. With 3 buffers, the
+///          download of run j - 1 also overlaps with the staging and upload
+///          of run j + 1; with 2, they share a buffer and wait for it. With
+///          1 buffer, runs are uploaded, sorted and downloaded in turn.
+///          Sorted runs are merged on host by one thread per part
+///          of the output: splitters sampled from the runs cut every run in
+///          pieces, and a thread merges the pieces of its part with a heap.
+///          Host device systems sort runs in turn.
+/// \tparam T Type of keys
+///-----------------------------------------------------------------------------
+template <typename T>
+class ExternalSorter {
+
+public:
+
+    /// \param run_items Keys per run
+    /// \param n_buffers Device buffers, 2 for double, 3 for triple buffering
+    ExternalSorter(size_t run_items, int n_buffers)
+        : _run_items(run_items), _n(0) {
+
+        if (run_items == 0 || n_buffers < 1)
+            throw std::invalid_argument("An external sorter needs runs of "
+                                        "one key or more and a buffer");
+
+        for (int b = 0; b < n_buffers; ++b) {
+            _device.emplace_back(run_items);
+#ifdef USE_HIP
+            // Host buffers hold whole 8-byte words
+            size_t bytes = (run_items * sizeof(T) + 7) / 8 * 8;
+            _staging.emplace_back(new gpuutils::HostBuffer(
+                                      bytes, gpuutils::HostMemory::pinned));
+#endif
+        }
+    }
+
+    /// \brief Get the run size fitting a budget of device memory
+    /// \details The temporaries of a sort are counted as large as its run.
+    /// \param budget    Bytes of device memory for all buffers
+    /// \param n_buffers Device buffers
+    static size_t runItems(size_t budget, int n_buffers) {
+        return budget / (size_t(n_buffers) * 2 * sizeof(T));
+    }
+
+    size_t runSize() const { return _run_items; }
+
+    int buffers() const { return int(_device.size()); }
+
+    /// \brief Get the number of runs of the last input
+    size_t runs() const { return (_n + _run_items - 1) / _run_items; }
+
+    /// \brief Sort a host range run by run into host memory of the sorter
+    /// \param first, last Random-access range of keys on host, a vector or
+    ///                    a mapped file
+    template <typename InputIterator>
+    void sortRuns(InputIterator first, InputIterator last) {
+
+        _n = std::distance(first, last);
+        _runs.resize(_n);
+
+        size_t n_runs = runs();
+
+#ifdef USE_HIP
+        // Run j is uploaded before run j - 1 is sorted, given two buffers
+        size_t n_bufs = _device.size();
+        size_t ahead  = n_bufs > 1 ? 1 : 0;
+        for (size_t j = 0; j < n_runs + ahead; ++j) {
+            if (j < n_runs) {
+                // Run j reuses the buffers of run j - B
+                if (j >= n_bufs)
+                    collect(j - n_bufs);
+                upload(first, j);
+            }
+            if (j >= ahead)
+                sortRun(j - ahead);
+        }
+
+        size_t j = n_runs > n_bufs ? n_runs - n_bufs : 0;
+        for (; j < n_runs; ++j)
+            collect(j);
+#else
+        auto &run = _device[0];
+        for (size_t j = 0; j < n_runs; ++j) {
+            auto begin = first + j * _run_items;
+            thrust::copy(begin, begin + length(j), run.begin());
+            thrust::sort(gpuutils::policy(), run.begin(),
+                         run.begin() + length(j));
+            thrust::copy(run.begin(), run.begin() + length(j),
+                         _runs.begin() + j * _run_items);
+        }
+#endif
+    }
+
+    /// \brief Merge the sorted runs into a host range of as many keys as
+    ///        the input
+    /// \details Parts are balanced for distinct keys. Keys equal to a
+    ///          splitter all go to the same part.
+    template <typename OutputIterator>
+    void merge(OutputIterator result) {
+
+        size_t n_runs = runs();
+        if (n_runs <= 1) {
+            std::copy(_runs.begin(), _runs.end(), result);
+            return;
+        }
+
+        size_t n_parts = std::max(1u, std::thread::hardware_concurrency());
+        auto bounds    = partBounds(n_parts);
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < n_parts; ++p) {
+            threads.emplace_back([&, p] {
+                size_t offset = 0;
+                for (size_t r = 0; r < n_runs; ++r)
+                    offset += bounds[p][r] - r * _run_items;
+                mergePart(bounds[p], bounds[p + 1], result + offset);
+            });
+        }
+
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    /// \brief Sort a host range into another one
+    template <typename InputIterator, typename OutputIterator>
+    void sort(InputIterator first, InputIterator last,
+              OutputIterator result) {
+        sortRuns(first, last);
+        merge(result);
+    }
+
+private:
+
+    /// \brief Get the number of keys of run j of the last input
+    size_t length(size_t j) const {
+        return std::min(_run_items, _n - j * _run_items);
+    }
+
+#ifdef USE_HIP
+    /// \brief Stage run j in pinned memory and upload it, not waiting
+    template <typename InputIterator>
+    void upload(InputIterator first, size_t j) {
+        size_t b     = j % _device.size();
+        size_t keys  = length(j);
+        auto begin   = first + j * _run_items;
+        auto staging = reinterpret_cast<T*>(_staging[b]->data());
+        auto run     = thrust::raw_pointer_cast(_device[b].data());
+
+        std::copy(begin, begin + keys, staging);
+        hipMemcpyAsync(run, staging, keys * sizeof(T),
+                       hipMemcpyHostToDevice, gpuutils::pipelineStream(int(b)));
+    }
+
+    /// \brief Sort uploaded run j and download it
+    /// \details The sort is ordered after the upload on the stream of the
+    ///          run and returns once done; the download does not wait.
+    void sortRun(size_t j) {
+        size_t b     = j % _device.size();
+        size_t keys  = length(j);
+        auto stream  = gpuutils::pipelineStream(int(b));
+        auto staging = reinterpret_cast<T*>(_staging[b]->data());
+        auto run     = thrust::raw_pointer_cast(_device[b].data());
+
+        thrust::sort(thrust::hip::par(gpuutils::temporaryAllocator())
+                         .on(stream),
+                     _device[b].begin(), _device[b].begin() + keys);
+        hipMemcpyAsync(staging, run, keys * sizeof(T),
+                       hipMemcpyDeviceToHost, stream);
+    }
+
+    /// \brief Wait for the download of run j and copy it out of its buffer
+    void collect(size_t j) {
+        size_t b     = j % _device.size();
+        auto staging = reinterpret_cast<T*>(_staging[b]->data());
+
+        hipStreamSynchronize(gpuutils::pipelineStream(int(b)));
+        std::copy(staging, staging + length(j),
+                  _runs.begin() + j * _run_items);
+    }
+#endif
+
+    /// \brief Cut every run at splitters sampled from the runs
+    /// \return For each of the n_parts + 1 bounds, the index in _runs of
+    ///         the first key of every run from the bound up
+    std::vector<std::vector<size_t>> partBounds(size_t n_parts) const {
+
+        size_t n_runs = runs();
+
+        // Evenly spaced keys of each sorted run, 64 per part
+        std::vector<T> samples;
+        for (size_t r = 0; r < n_runs; ++r)
+            for (size_t i = 0; i < 64 * n_parts; ++i)
+                samples.push_back(_runs[r * _run_items
+                                        + i * length(r) / (64 * n_parts)]);
+        std::sort(samples.begin(), samples.end());
+
+        std::vector<std::vector<size_t>> bounds(n_parts + 1,
+                                                std::vector<size_t>(n_runs));
+        for (size_t r = 0; r < n_runs; ++r) {
+            auto begin = _runs.begin() + r * _run_items;
+            auto end   = begin + length(r);
+
+            bounds[0][r]       = r * _run_items;
+            bounds[n_parts][r] = r * _run_items + length(r);
+            for (size_t p = 1; p < n_parts; ++p) {
+                T splitter   = samples[p * samples.size() / n_parts];
+                bounds[p][r] = std::lower_bound(begin, end, splitter)
+                             - _runs.begin();
+            }
+        }
+
+        return bounds;
+    }
+
+    /// \brief Merge the pieces [first[r], last[r]) of every run r
+    template <typename OutputIterator>
+    void mergePart(const std::vector<size_t> &first,
+                   const std::vector<size_t> &last,
+                   OutputIterator result) const {
+
+        using Head = std::pair<T, size_t>;     ///< Key, run
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+
+        auto cursor = first;
+        for (size_t r = 0; r < cursor.size(); ++r)
+            if (cursor[r] < last[r])
+                heap.emplace(_runs[cursor[r]], r);
+
+        while (!heap.empty()) {
+            size_t r = heap.top().second;
+            *result++ = heap.top().first;
+            heap.pop();
+
+            if (++cursor[r] < last[r])
+                heap.emplace(_runs[cursor[r]], r);
+        }
+    }
+
+    size_t _run_items;
+    size_t _n;          ///< Keys of the last input
+
+    ///< Device buffers, one run each
+    std::vector<thrust::device_vector<T>> _device;
+
+    ///< Pinned staging buffers, one per device buffer
+    std::vector<std::unique_ptr<gpuutils::HostBuffer>> _staging;
+
+    ///< Sorted runs of the last input, back to back
+    std::vector<T> _runs;
+};
+
+
+/// \brief Sort a host vector larger than device memory into another one
+template <typename T>
+void run_external_sort(ExternalSorter<T> &sorter,
+                       const thrust::host_vector<T> &X,
+                       thrust::host_vector<T> &Y) {
+    sorter.sort(X.begin(), X.end(), Y.begin());
+}
+
+
+/// \brief Traffic of run_external_sort, upload, sort and download every
+///        key
+/// \details The merge runs on host and is left out; its time is the
+///          merge_time counter of bm_external_sort.
+template <typename T>
+benchutils::Traffic traffic_external_sort(size_t n) {
+    return benchutils::Traffic::transfer(n, sizeof(T))     // upload
+         + traffic_sort<T>(n)
+         + benchutils::Traffic::transfer(n, sizeof(T));    // download
+}
+
+
+#endif  // BENCHMARK_EXTERNAL_H_
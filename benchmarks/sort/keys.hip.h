@@ -0,0 +1,90 @@
+#ifndef BENCHMARK_SORT_KEYS_H_
+#define BENCHMARK_SORT_KEYS_H_
+
+#include <thrust/device_vector.h>
+#include <thrust/tabulate.h>
+#include <cstdint>
+#include <type_traits>
+
+#include "utils/generators.h"    /* makeData, hash_bits */
+
+
+/// \brief Distributions of sort keys
+enum class KeyDistribution : int {
+    uniform = 0,        ///< Uniformly random keys
+    zipf,               ///< Zipf-distributed ranks with s = 1
+    few_unique,         ///< 16 distinct keys
+    nearly_sorted,      ///< Ascending keys, 1% of them out of place
+    reverse_sorted      ///< Descending keys
+};
+
+///< Number of key distributions
+constexpr int n_key_distributions = 5;
+
+
+/// \brief Get the name of a key distribution
+inline const char* key_distribution_name(KeyDistribution dist) {
+    switch (dist) {
+        case KeyDistribution::uniform:          return "uniform";
+        case KeyDistribution::zipf:             return "zipf";
+        case KeyDistribution::few_unique:       return "few_unique";
+        case KeyDistribution::nearly_sorted:    return "nearly_sorted";
+        case KeyDistribution::reverse_sorted:   return "reverse_sorted";
+    }
+    return "unknown";
+}
+
+
+/// \brief A functor for computing the i-th key of a distribution
+/// \details Only for the sort-specific distributions, uniform and Zipf keys
+///          come from benchutils::generate.
+template <typename T>
+struct key_generator {
+
+    KeyDistribution       dist;
+    benchutils::hash_bits bits;
+    benchutils::hash_bits extra_bits;
+    uint64_t              n;
+
+    __host__ __device__
+    T operator()(uint64_t i) const {
+        switch (dist) {
+            case KeyDistribution::nearly_sorted:
+                return benchutils::bits_to_unit(bits(i)) < 0.01
+                    ? T(extra_bits(i) % n) : T(i);
+            case KeyDistribution::reverse_sorted:
+                return T(n - 1 - i);
+            case KeyDistribution::few_unique:
+            default:
+                return T(bits(i) % 16);
+        }
+    }
+};
+
+
+/// \brief Fill a vector with keys drawn from a distribution
+/// \param X    Device vector to fill
+/// \param dist Key distribution
+/// \param seed Random seed
+template <typename T>
+void generate_keys(thrust::device_vector<T> &X, KeyDistribution dist,
+                   uint64_t seed = 42) {
+
+    using benchutils::Distribution;
+
+    switch (dist) {
+        case KeyDistribution::uniform:
+            benchutils::makeData(X, {Distribution::uniform, seed});
+            return;
+        case KeyDistribution::zipf:
+            benchutils::makeData(X, {Distribution::zipf, seed});
+            return;
+        default:
+            thrust::tabulate(X.begin(), X.end(),
+                key_generator<T>{dist, benchutils::hash_bits{seed},
+                                 benchutils::hash_bits{~seed}, X.size()});
+    }
+}
+
+
+#endif  // BENCHMARK_SORT_KEYS_H_
@@ -1,16 +1,179 @@
 #ifndef BENCHMARK_SORT_H_
 #define BENCHMARK_SORT_H_
 
+#include <thrust/copy.h>
 #include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
 #include <thrust/functional.h>
+#include <thrust/host_vector.h>
 #include <thrust/sequence.h>
 #include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <type_traits>
+
+#include "utils/allocators.h"    /* policy */
+#include "utils/dispatch.h"      /* crossover */
+#include "utils/generators.h"    /* generate */
+#include "utils/traffic.h"       /* Traffic */
 
 
 /// \brief Sort vector elements on device
+template <typename T, typename Alloc>
+void run_sort(thrust::device_vector<T, Alloc> &X) {
+    thrust::sort(gpuutils::policy(), X.begin(), X.end(), thrust::greater<T>());
+}
+
+
+/// \brief Sort keys in ascending order on device
+template <typename T, typename Alloc>
+void run_sort_keys(thrust::device_vector<T, Alloc> &X) {
+    thrust::sort(gpuutils::policy(), X.begin(), X.end());
+}
+
+
+/// \brief Stably sort keys in ascending order on device
+template <typename T, typename Alloc>
+void run_stable_sort(thrust::device_vector<T, Alloc> &X) {
+    thrust::stable_sort(gpuutils::policy(), X.begin(), X.end());
+}
+
+
+/// \brief Traffic of an in-place sort of n keys
+/// \details A lower bound, read and write the keys once. The passes of a
+///          radix sort or a merge sort multiply it, so peak% is low by design.
+template <typename T>
+benchutils::Traffic traffic_sort(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 1);
+}
+
+
+/// \brief Sort key-value pairs by keys in ascending order on device
+template <typename K, typename V, typename KAlloc, typename VAlloc>
+void run_sort_by_key(thrust::device_vector<K, KAlloc> &keys,
+                     thrust::device_vector<V, VAlloc> &values) {
+    thrust::sort_by_key(gpuutils::policy(),
+                        keys.begin(), keys.end(), values.begin());
+}
+
+
+/// \brief Traffic of sorting n key-value pairs, a lower bound
+template <typename K, typename V>
+benchutils::Traffic traffic_sort_by_key(size_t n) {
+    return traffic_sort<K>(n) + traffic_sort<V>(n);
+}
+
+
+/// \brief A functor reversing the order of keys, f(x) < f(y) iff x > y
+/// \details Integers are flipped bitwise (~x == -1 - x, no overflow for
+///          signed types) and IEEE floats are negated. Both are exact
+///          involutions, so applying the functor twice restores the keys.
+///          NaNs are not ordered.
+template <typename T>
+struct order_flip {
+
+    __host__ __device__
+    T operator()(const T &x) const {
+        return flip(x, std::is_integral<T>());
+    }
+
+    __host__ __device__
+    static T flip(const T &x, std::true_type /* is_integral */) {
+        return ~x;
+    }
+
+    __host__ __device__
+    static T flip(const T &x, std::false_type /* is_integral */) {
+        return -x;
+    }
+};
+
+
+/// \brief Sort keys in descending order on device without a comparator
+/// \details Keys are flipped, sorted with the default comparator so that
+///          thrust keeps its radix sort path, and flipped back.
+template <typename T, typename Alloc>
+void run_sort_descending(thrust::device_vector<T, Alloc> &X) {
+    thrust::transform(gpuutils::policy(),
+                      X.begin(), X.end(), X.begin(), order_flip<T>());
+    thrust::sort(gpuutils::policy(), X.begin(), X.end());
+    thrust::transform(gpuutils::policy(),
+                      X.begin(), X.end(), X.begin(), order_flip<T>());
+}
+
+
+/// \brief Traffic of run_sort_descending, a sort and two flips
+template <typename T>
+benchutils::Traffic traffic_sort_descending(size_t n) {
+    return traffic_sort<T>(n) + benchutils::Traffic::items(n, sizeof(T), 2, 2);
+}
+
+
+/// \brief Sort key-value pairs by keys in descending order on device
+///        without a comparator
+template <typename K, typename V, typename KAlloc, typename VAlloc>
+void run_sort_by_key_descending(thrust::device_vector<K, KAlloc> &keys,
+                                thrust::device_vector<V, VAlloc> &values) {
+    thrust::transform(gpuutils::policy(),
+                      keys.begin(), keys.end(), keys.begin(), order_flip<K>());
+    thrust::sort_by_key(gpuutils::policy(),
+                        keys.begin(), keys.end(), values.begin());
+    thrust::transform(gpuutils::policy(),
+                      keys.begin(), keys.end(), keys.begin(), order_flip<K>());
+}
+
+
+///----------------------------------------------------------------------------
+/// Host/device dispatch
+///----------------------------------------------------------------------------
+
+/// \brief Sort keys of a host vector with the host system
+template <typename T>
+void host_sort_keys(thrust::host_vector<T> &X) {
+    thrust::sort(thrust::host, X.begin(), X.end());
+}
+
+
+/// \brief Sort keys of a host vector on device, copies included
+template <typename T>
+void device_sort_keys(thrust::host_vector<T> &X) {
+    thrust::device_vector<T> dev_X(X);
+    run_sort_keys(dev_X);
+    thrust::copy(dev_X.begin(), dev_X.end(), X.begin());
+}
+
+
+/// \brief Get the size from which dispatch_sort_keys runs on device
+/// \details Calibration sorts a copy of uniform keys in every call, which
+///          adds the same host copy to both targets.
+template <typename T>
+size_t sort_keys_crossover() {
+    static const size_t crossover = benchutils::crossover(
+        benchutils::tuningKey<T>("sort_keys"),
+        [](size_t n) {
+            thrust::host_vector<T> keys(n);
+            benchutils::generate(keys, benchutils::DataSpec());
+            return keys;
+        },
+        [](thrust::host_vector<T> &keys) {
+            auto X = keys;
+            host_sort_keys(X);
+        },
+        [](thrust::host_vector<T> &keys) {
+            auto X = keys;
+            device_sort_keys(X);
+        });
+
+    return crossover;
+}
+
+
+/// \brief Sort keys of a host vector on host below the crossover size
 template <typename T>
-void run_sort(thrust::device_vector<T> &X) {
-    thrust::sort(X.begin(), X.end(), thrust::greater<T>());
+void dispatch_sort_keys(thrust::host_vector<T> &X) {
+    if (X.size() < sort_keys_crossover<T>())
+        host_sort_keys(X);
+    else
+        device_sort_keys(X);
 }
 
 
@@ -0,0 +1,289 @@
+#ifndef BENCHMARK_TOPK_H_
+#define BENCHMARK_TOPK_H_
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/device_vector.h>
+#include <thrust/extrema.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+#include "sort.hip.h"   /* order_flip, run_sort */
+
+#include "utils/allocators.h"    /* policy, temporary_vector */
+#include "utils/generators.h"    /* hash_bits */
+#include "utils/traffic.h"       /* Traffic */
+
+
+///----------------------------------------------------------------------------
+/// Top-k selection with a sampled threshold
+///----------------------------------------------------------------------------
+
+///< Items sampled to choose the threshold
+constexpr size_t top_k_sample = size_t(1) << 16;
+
+
+/// \brief A functor for the index of the i-th sampled item, with replacement
+struct sample_index {
+
+    benchutils::hash_bits bits;
+    uint64_t              n;
+
+    __host__ __device__
+    size_t operator()(size_t i) const {
+        return size_t(bits(i) % n);
+    }
+};
+
+
+/// \brief A predicate selecting flipped keys up to a threshold
+/// \details Keys are compared flipped, so that it selects the original keys
+///          from the threshold up.
+template <typename T>
+struct at_most {
+
+    T threshold;
+
+    __host__ __device__
+    bool operator()(const T &x) const {
+        return !(threshold < x);
+    }
+};
+
+
+/// \brief Get the rank in a sorted sample of the threshold for k of n items
+/// \details About k * s / n sampled items are above the k-th largest item.
+///          Three standard deviations more make a threshold below it, with
+///          k survivors or more, in all but 0.1% of the calls.
+inline size_t top_k_rank(size_t n, size_t k, size_t s) {
+    double mean = double(k) * s / n;
+    auto rank   = size_t(std::ceil(mean + 3 * std::sqrt(mean))) + 1;
+    return std::min(rank, s - 1);
+}
+
+
+/// \brief Sample keys on device, flipped and sorted
+/// \return Flipped keys in ascending order, the original ones descending
+template <typename T>
+gpuutils::temporary_vector<T> top_k_sample_keys(thrust::device_vector<T> &X) {
+
+    size_t s = std::min(X.size(), top_k_sample);
+    gpuutils::temporary_vector<T> sample(s);
+
+    auto indices = thrust::make_transform_iterator(
+                       thrust::make_counting_iterator<size_t>(0),
+                       sample_index{benchutils::hash_bits{42}, X.size()});
+    auto keys    = thrust::make_permutation_iterator(
+                       thrust::make_transform_iterator(X.begin(),
+                                                       order_flip<T>()),
+                       indices);
+
+    thrust::copy(gpuutils::policy(), keys, keys + s, sample.begin());
+    thrust::sort(gpuutils::policy(), sample.begin(), sample.end());
+    return sample;
+}
+
+
+/// \brief Choose a threshold with at least k keys of X above it
+/// \details Thresholds are taken from a sample, lower and lower until k
+///          keys survive. With the last one every key survives.
+/// \param  X         Keys
+/// \param  k         Number of keys to keep
+/// \param  threshold Flipped threshold, set
+/// \return Number of keys of X from the threshold up
+template <typename T>
+size_t top_k_threshold(thrust::device_vector<T> &X, size_t k, T &threshold) {
+
+    auto sample  = top_k_sample_keys(X);
+    auto flipped = thrust::make_transform_iterator(X.begin(), order_flip<T>());
+
+    for (size_t rank = top_k_rank(X.size(), k, sample.size());;
+         rank = std::min(2 * rank + 1, sample.size() - 1)) {
+
+        threshold = sample[rank];
+        size_t survivors = thrust::count_if(gpuutils::policy(),
+                                            flipped, flipped + X.size(),
+                                            at_most<T>{threshold});
+
+        if (survivors >= k)
+            return survivors;
+        if (rank == sample.size() - 1)
+            break;
+    }
+
+    // Every key is from the largest flipped key up
+    threshold = *thrust::max_element(gpuutils::policy(),
+                                     flipped, flipped + X.size());
+    return thrust::count_if(gpuutils::policy(), flipped, flipped + X.size(),
+                            at_most<T>{threshold});
+}
+
+
+/// \brief Get the k largest keys on device, in descending order
+/// \details Keys from a sampled threshold up are copied, flipped, with
+///          copy_if, their radix sort is small, and the first k are
+///          flipped back. X is not modified.
+/// \param X   Keys
+/// \param top Largest keys, k = top.size() items, set
+template <typename T>
+void run_top_k(thrust::device_vector<T> &X, thrust::device_vector<T> &top) {
+
+    size_t k = top.size();
+    if (k > X.size())
+        throw std::invalid_argument("Top-k of fewer than k keys");
+    if (k == 0)
+        return;
+
+    T threshold;
+    size_t survivors = top_k_threshold(X, k, threshold);
+
+    auto flipped = thrust::make_transform_iterator(X.begin(), order_flip<T>());
+    gpuutils::temporary_vector<T> candidates(survivors);
+    thrust::copy_if(gpuutils::policy(), flipped, flipped + X.size(),
+                    candidates.begin(), at_most<T>{threshold});
+
+    thrust::sort(gpuutils::policy(), candidates.begin(), candidates.end());
+
+    auto largest = thrust::make_transform_iterator(candidates.begin(),
+                                                   order_flip<T>());
+    thrust::copy(gpuutils::policy(), largest, largest + k, top.begin());
+}
+
+
+/// \brief Traffic of run_top_k with about k survivors, a lower bound
+/// \details Counting and copy_if read the keys, survivors are written,
+///          sorted, and k of them copied.
+template <typename T>
+benchutils::Traffic traffic_top_k(size_t n, size_t k) {
+    return benchutils::Traffic::items(n, sizeof(T), 2, 0)
+         + benchutils::Traffic::items(k, sizeof(T), 0, 1)
+         + traffic_sort<T>(k)
+         + benchutils::Traffic::items(k, sizeof(T), 1, 1);
+}
+
+
+/// \brief Get the key-value pairs of the k largest keys on device, in
+///        descending order of keys
+/// \details Pairs are selected with the same threshold as run_top_k, so
+///          that only values of survivors are copied and sorted.
+template <typename K, typename V>
+void run_top_k_by_key(thrust::device_vector<K> &keys,
+                      thrust::device_vector<V> &values,
+                      thrust::device_vector<K> &top_keys,
+                      thrust::device_vector<V> &top_values) {
+
+    size_t k = top_keys.size();
+    if (k > keys.size() || top_values.size() != k)
+        throw std::invalid_argument("Top-k of fewer than k pairs");
+    if (k == 0)
+        return;
+
+    K threshold;
+    size_t survivors = top_k_threshold(keys, k, threshold);
+
+    auto flipped = thrust::make_transform_iterator(keys.begin(),
+                                                   order_flip<K>());
+    auto pairs   = thrust::make_zip_iterator(thrust::make_tuple(
+                       flipped, values.begin()));
+
+    gpuutils::temporary_vector<K> candidate_keys(survivors);
+    gpuutils::temporary_vector<V> candidate_values(survivors);
+    thrust::copy_if(gpuutils::policy(), pairs, pairs + keys.size(), flipped,
+                    thrust::make_zip_iterator(thrust::make_tuple(
+                        candidate_keys.begin(), candidate_values.begin())),
+                    at_most<K>{threshold});
+
+    thrust::sort_by_key(gpuutils::policy(),
+                        candidate_keys.begin(), candidate_keys.end(),
+                        candidate_values.begin());
+
+    auto largest = thrust::make_transform_iterator(candidate_keys.begin(),
+                                                   order_flip<K>());
+    thrust::copy(gpuutils::policy(), largest, largest + k, top_keys.begin());
+    thrust::copy(gpuutils::policy(), candidate_values.begin(),
+                 candidate_values.begin() + k, top_values.begin());
+}
+
+
+/// \brief Traffic of run_top_k_by_key with about k survivors, a lower bound
+/// \details Keys are read twice and values once, as if copy_if read values
+///          of survivors only.
+template <typename K, typename V>
+benchutils::Traffic traffic_top_k_by_key(size_t n, size_t k) {
+    return traffic_top_k<K>(n, k)
+         + benchutils::Traffic::items(k, sizeof(V), 1, 1)
+         + traffic_sort<V>(k)
+         + benchutils::Traffic::items(k, sizeof(V), 1, 1);
+}
+
+
+///----------------------------------------------------------------------------
+/// Top-k by a full sort, the baseline
+///----------------------------------------------------------------------------
+
+/// \brief Get the k largest keys by sorting a copy and truncating it
+/// \param X    Keys
+/// \param work Buffer of X.size() keys, sorted
+/// \param top  Largest keys, k = top.size() items, set
+template <typename T>
+void run_top_k_by_sort(thrust::device_vector<T> &X,
+                       thrust::device_vector<T> &work,
+                       thrust::device_vector<T> &top) {
+    thrust::copy(gpuutils::policy(), X.begin(), X.end(), work.begin());
+    run_sort(work);
+    thrust::copy(gpuutils::policy(),
+                 work.begin(), work.begin() + top.size(), top.begin());
+}
+
+
+/// \brief Traffic of run_top_k_by_sort, a copy, a sort and k copied
+template <typename T>
+benchutils::Traffic traffic_top_k_by_sort(size_t n, size_t k) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 1)
+         + traffic_sort<T>(n)
+         + benchutils::Traffic::items(k, sizeof(T), 1, 1);
+}
+
+
+/// \brief Get the pairs of the k largest keys by sorting copies of keys
+///        and values and truncating them
+template <typename K, typename V>
+void run_top_k_by_key_by_sort(thrust::device_vector<K> &keys,
+                              thrust::device_vector<V> &values,
+                              thrust::device_vector<K> &work_keys,
+                              thrust::device_vector<V> &work_values,
+                              thrust::device_vector<K> &top_keys,
+                              thrust::device_vector<V> &top_values) {
+    size_t k = top_keys.size();
+
+    thrust::copy(gpuutils::policy(),
+                 keys.begin(), keys.end(), work_keys.begin());
+    thrust::copy(gpuutils::policy(),
+                 values.begin(), values.end(), work_values.begin());
+    run_sort_by_key_descending(work_keys, work_values);
+
+    thrust::copy(gpuutils::policy(),
+                 work_keys.begin(), work_keys.begin() + k, top_keys.begin());
+    thrust::copy(gpuutils::policy(), work_values.begin(),
+                 work_values.begin() + k, top_values.begin());
+}
+
+
+/// \brief Traffic of run_top_k_by_key_by_sort
+template <typename K, typename V>
+benchutils::Traffic traffic_top_k_by_key_by_sort(size_t n, size_t k) {
+    return traffic_top_k_by_sort<K>(n, k) + traffic_top_k_by_sort<V>(n, k)
+         + benchutils::Traffic::items(n, sizeof(K), 2, 2);
+}
+
+
+#endif  // BENCHMARK_TOPK_H_
@@ -1,8 +1,31 @@
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <memory>
 
+#include "utils/segments.h"     /* make_offsets, random_lengths */
+#include "utils/cold_start.h"   /* COLD_START */
+#include "utils/counters.h"     /* allocator and traffic counters */
+#include "utils/host_memory.h"  /* HostBuffer, HostMemory */
+#include "utils/inputs.h"       /* InputKind, withInput */
+#include "utils/timing.h"       /* IterationTimer */
 #include "sum.hip.h"
 
 
+///< Value of every item. It is not exact in binary, so rounding errors
+///< show up, while the exact sum of N items is still N * T(0.1).
+constexpr double item_value = 0.1;
+
+
+/// \brief Relative error of a sum of N items equal to T(item_value)
+template <typename T, typename R>
+double relative_error(R sum, size_t N) {
+    long double reference = (long double)T(item_value) * N;
+    return double(std::fabs((long double)sum - reference) / reference);
+}
+
+
 ///----------------------------------------------------------------------------
 /// thrust::reduce for sum
 ///----------------------------------------------------------------------------
@@ -16,27 +39,371 @@ void reduce_sum(benchmark::State &state) {
     T sum = 0.;
 
     // Allocate a device vector.
-    thrust::device_vector<T> X(N << 20, 1);
+    thrust::device_vector<T> X(N << 20, T(item_value));
+
+    benchutils::resetAllocatorCounters();
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { sum = run_sum(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sum<T>(N << 20));
+    timer.setCounters();
+    state.counters["rel_error"] = relative_error<T>(sum, N << 20);
+    benchutils::setAllocatorCounters(state, timer.batch());
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::reduce for sum with a double accumulator
+///----------------------------------------------------------------------------
+template <typename T>
+void reduce_sum_widened(benchmark::State &state) {
+
+    // Number of values (million)
+    size_t N = state.range(0);
+
+    // Sum of the vector elements
+    double sum = 0.;
+
+    // Allocate a device vector.
+    thrust::device_vector<T> X(N << 20, T(item_value));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { sum = run_sum_widened<double>(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sum<T>(N << 20));
+    timer.setCounters();
+    state.counters["rel_error"] = relative_error<T>(sum, N << 20);
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::transform_reduce for compensated sum
+///----------------------------------------------------------------------------
+template <typename T>
+void reduce_sum_compensated(benchmark::State &state) {
+
+    // Number of values (million)
+    size_t N = state.range(0);
+
+    // Sum of the vector elements
+    T sum = 0.;
+
+    // Allocate a device vector.
+    thrust::device_vector<T> X(N << 20, T(item_value));
 
+    benchutils::IterationTimer timer(state);
     for (auto _ : state) {
-        sum = run_sum(X);
+        timer.time([&] { sum = run_sum_compensated(X); });
     }
 
-    state.SetBytesProcessed(int64_t(state.iterations())
-                            * int64_t(sizeof(T) * N << 20));
+    benchutils::setTrafficCounters(state, traffic_sum_compensated<T>(N << 20));
+    timer.setCounters();
+    state.counters["rel_error"] = relative_error<T>(sum, N << 20);
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::reduce_by_key for blocked pairwise sum
+///----------------------------------------------------------------------------
+template <typename T>
+void reduce_sum_pairwise(benchmark::State &state) {
+
+    // Number of values (million)
+    size_t N = state.range(0);
+
+    // Sum of the vector elements
+    T sum = 0.;
+
+    // Allocate a device vector.
+    thrust::device_vector<T> X(N << 20, T(item_value));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { sum = run_sum_pairwise(X); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sum_pairwise<T>(N << 20));
+    timer.setCounters();
+    state.counters["rel_error"] = relative_error<T>(sum, N << 20);
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::reduce for 1K to 4M values, launch latency
+///----------------------------------------------------------------------------
+template <typename T>
+void reduce_sum_latency(benchmark::State &state) {
+
+    // Number of values
+    size_t n = state.range(0);
+
+    // Allocate a device vector
+    thrust::device_vector<T> X(n, T(item_value));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(run_sum(X)); });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sum<T>(n));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// thrust::reduce for host vectors, dispatched to host or device
+///----------------------------------------------------------------------------
+template <typename T>
+void reduce_sum_dispatch(benchmark::State &state) {
+
+    // Number of values
+    size_t n = state.range(0);
+
+    // Allocate a host vector
+    thrust::host_vector<T> X(n, T(item_value));
+
+    // Calibrate the crossover before timing, if needed
+    dispatch_sum(X);
+
+    // Host calls are not seen by events
+    benchutils::IterationTimer timer(state, benchutils::options().timing_batch,
+                                     /* events */ false);
+    for (auto _ : state) {
+        timer.time([&] { benchmark::DoNotOptimize(dispatch_sum(X)); });
+    }
+
+    timer.setCounters();
+    state.SetLabel(n < sum_crossover<T>() ? "host" : "device");
+}
+
+
+///----------------------------------------------------------------------------
+/// Sums of a batch of small vectors, one launch per batch
+///----------------------------------------------------------------------------
+template <typename T>
+void reduce_sum_batched(benchmark::State &state) {
+
+    // Number of vectors in a batch, random lengths of 1 to 511 items
+    size_t n_vectors = state.range(0);
+    auto lengths     = benchutils::random_lengths(n_vectors, 256);
+
+    thrust::device_vector<size_t> offsets = benchutils::make_offsets(lengths);
+    size_t n = offsets.back();
+
+    // Allocate flat buffers
+    thrust::device_vector<T> X(n, T(item_value));
+    thrust::device_vector<T> sums(n_vectors);
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] { run_sum_batched(X, offsets, sums); });
+    }
+
+    benchutils::setTrafficCounters(state,
+                                   traffic_sum_batched<T>(n, n_vectors));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Sums of a batch of small vectors, one call per vector
+///----------------------------------------------------------------------------
+template <typename T>
+void reduce_sum_looped(benchmark::State &state) {
+
+    // Number of vectors in a batch, random lengths of 1 to 511 items
+    size_t n_vectors = state.range(0);
+    auto lengths     = benchutils::random_lengths(n_vectors, 256);
+    size_t n = thrust::reduce(lengths.begin(), lengths.end());
+
+    // Allocate one device vector per problem
+    std::vector<thrust::device_vector<T>> vectors;
+    for (auto length : lengths)
+        vectors.emplace_back(length, T(item_value));
+
+    benchutils::IterationTimer timer(state);
+    for (auto _ : state) {
+        timer.time([&] {
+            for (auto &X : vectors)
+                benchmark::DoNotOptimize(run_sum(X));
+        });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sum<T>(n));
+    timer.setCounters();
+}
+
+
+///----------------------------------------------------------------------------
+/// Sum of a host vector larger than a device buffer, chunk by chunk
+///----------------------------------------------------------------------------
+template <typename T>
+void reduce_sum_streaming(benchmark::State &state) {
+
+    // Number of items (million), chunk size (MiB), device buffers and
+    // host memory of the input
+    size_t N         = state.range(0);
+    size_t chunk     = (size_t(state.range(1)) << 20) / sizeof(T);
+    int    n_buffers = int(state.range(2));
+    auto   kind      = gpuutils::HostMemory(state.range(3));
+    bool   pinned    = kind == gpuutils::HostMemory::pinned;
+
+    // The input stays on host, the device only holds the buffers. Pinned
+    // input is copied to device as is, pageable input is staged first.
+    thrust::host_vector<T> X(pinned ? 0 : N << 20, T(item_value));
+    std::unique_ptr<gpuutils::HostBuffer> P;
+    if (pinned) {
+        P.reset(new gpuutils::HostBuffer((N << 20) * sizeof(T), kind));
+        auto data = reinterpret_cast<T*>(P->data());
+        std::fill(data, data + (N << 20), T(item_value));
+    }
+    gpuutils::StreamingReducer<T> reducer(chunk, n_buffers);
+
+    // Copies and reductions run on pipeline streams
+    benchutils::IterationTimer timer(state, benchutils::options().timing_batch,
+                                     /* events */ false);
+    for (auto _ : state) {
+        timer.time([&] {
+            benchmark::DoNotOptimize(pinned
+                ? run_sum_streaming(reducer,
+                                    reinterpret_cast<T*>(P->data()), N << 20)
+                : run_sum_streaming(reducer, X));
+        });
+    }
+
+    benchutils::setTrafficCounters(state, traffic_sum_streaming<T>(N << 20));
+    timer.setCounters();
+    state.SetLabel(gpuutils::hostMemoryName(kind));
+}
+
+
+/// \brief Arguments (million items, chunk MiB, buffers, host memory) for
+///        streaming, pageable and pinned input
+void reduce_sum_streaming_arguments(benchmark::internal::Benchmark *b) {
+    for (auto kind : {gpuutils::HostMemory::pageable,
+                      gpuutils::HostMemory::pinned})
+        for (int n_buffers = 1; n_buffers <= 3; ++n_buffers)
+            for (int chunk = 4; chunk <= 256; chunk *= 4)
+                b->Args({1024, chunk, n_buffers, int(kind)});
+}
+
+
+///----------------------------------------------------------------------------
+/// Sum of materialized or generated inputs
+///----------------------------------------------------------------------------
+template <typename T>
+void reduce_sum_input(benchmark::State &state) {
+
+    // Number of items (million) and input kind
+    size_t N  = state.range(0);
+    auto kind = benchutils::InputKind(state.range(1));
+
+    // Only a materialized input is read from memory
+    auto traffic = kind == benchutils::InputKind::materialized
+                 ? traffic_sum<T>(N << 20)
+                 : traffic_sum_generated<T>(N << 20);
+
+    benchutils::withInput<T>(kind, N << 20, [&](auto X) {
+        benchutils::IterationTimer timer(state);
+        for (auto _ : state) {
+            timer.time([&] {
+                benchmark::DoNotOptimize(run_sum_input<T>(X, N << 20));
+            });
+        }
+
+        benchutils::setTrafficCounters(state, traffic);
+        timer.setCounters();
+    });
+
+    state.SetLabel(benchutils::inputKindName(kind));
 }
 
 
 /// Benchmark registration
 BENCHMARK_TEMPLATE(reduce_sum, float)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(8)
     ->Range(32, 4000);
 
 BENCHMARK_TEMPLATE(reduce_sum, double)
-    ->UseRealTime()
+    ->UseManualTime()
     ->Unit(benchmark::kMillisecond)
     ->RangeMultiplier(8)
     ->Range(32, 2000);
 
+BENCHMARK_TEMPLATE(reduce_sum_widened, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(8)
+    ->Range(32, 4000);
+
+BENCHMARK_TEMPLATE(reduce_sum_compensated, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(8)
+    ->Range(32, 4000);
+
+BENCHMARK_TEMPLATE(reduce_sum_compensated, double)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(8)
+    ->Range(32, 2000);
+
+BENCHMARK_TEMPLATE(reduce_sum_pairwise, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(8)
+    ->Range(32, 4000);
+
+BENCHMARK_TEMPLATE(reduce_sum_pairwise, double)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->RangeMultiplier(8)
+    ->Range(32, 2000);
+
+BENCHMARK_TEMPLATE(reduce_sum_latency, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(reduce_sum_dispatch, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 4 << 20);
+
+BENCHMARK_TEMPLATE(reduce_sum_batched, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(10)
+    ->Range(1, 100000);
+
+BENCHMARK_TEMPLATE(reduce_sum_looped, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond)
+    ->RangeMultiplier(10)
+    ->Range(1, 100000);
+
+BENCHMARK_TEMPLATE(reduce_sum_streaming, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(reduce_sum_streaming_arguments);
+
+BENCHMARK_TEMPLATE(reduce_sum_input, float)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Apply(benchutils::inputArguments);
+
+
+/// Cold-start registration, first calls on 1M items
+COLD_START("run_sum<float>", [] {
+    auto X = std::make_shared<thrust::device_vector<float>>(1 << 20, 1.f);
+    return [X] { benchmark::DoNotOptimize(run_sum(*X)); };
+});
@@ -1,15 +1,312 @@
 #ifndef BENCHMARK_SUM_H_
 #define BENCHMARK_SUM_H_
 
+#include <benchmark/benchmark.h>
 #include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
 #include <thrust/functional.h>
+#include <thrust/host_vector.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
 #include <thrust/reduce.h>
+#include <thrust/transform_reduce.h>
+
+#include "utils/allocators.h"    /* policy, temporary_vector */
+#include "utils/dispatch.h"      /* crossover */
+#include "utils/segments.h"      /* reduce_segments */
+#include "utils/streaming.h"     /* StreamingReducer */
+#include "utils/traffic.h"       /* Traffic */
 
 
 /// \brief Sum up vector elements on device
 template <typename T>
 T run_sum(thrust::device_vector<T> &X) {
-    return thrust::reduce(X.begin(), X.end(), (T)0, thrust::plus<T>());
+    return thrust::reduce(gpuutils::policy(),
+                          X.begin(), X.end(), (T)0, thrust::plus<T>());
+}
+
+
+/// \brief Traffic of a reduction of n items, read X, one addition per item
+/// \details Also the traffic of run_sum_widened, which widens on the fly.
+template <typename T>
+benchutils::Traffic traffic_sum(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 0, 1);
+}
+
+
+/// \brief A functor for widening a number, f(x) -> Acc(x)
+template <typename T, typename Acc>
+struct widen {
+
+    __host__ __device__
+    Acc operator()(const T &x) const {
+        return Acc(x);
+    }
+};
+
+
+/// \brief Sum up vector elements on device with a wider accumulator
+/// \details Items are widened on the fly, so the vector keeps its
+///          storage type and the memory traffic does not change.
+template <typename Acc = double, typename T>
+Acc run_sum_widened(thrust::device_vector<T> &X) {
+
+    auto first = thrust::make_transform_iterator(X.begin(), widen<T, Acc>());
+    auto last  = thrust::make_transform_iterator(X.end(), widen<T, Acc>());
+
+    return thrust::reduce(gpuutils::policy(),
+                          first, last, Acc(0), thrust::plus<Acc>());
+}
+
+
+/// \brief A partial sum with a running compensation for lost low-order bits
+template <typename T>
+struct compensated_sum {
+    T sum;
+    T carry;
+};
+
+
+/// \brief A functor for lifting a number to a compensated sum
+template <typename T>
+struct to_compensated {
+
+    __host__ __device__
+    compensated_sum<T> operator()(const T &x) const {
+        return compensated_sum<T>{x, T(0)};
+    }
+};
+
+
+/// \brief A functor for adding compensated sums (Neumaier)
+/// \details Unlike Kahan summation, the error term is exact whichever
+///          operand is larger, so it is safe for the unordered merges
+///          of a parallel reduction. The carry is folded back into the
+///          sum after each merge so that it stays below one ulp of the sum.
+template <typename T>
+struct neumaier_plus {
+
+    __host__ __device__
+    compensated_sum<T> operator()(const compensated_sum<T> &a,
+                                  const compensated_sum<T> &b) const {
+        T t     = a.sum + b.sum;
+        T abs_a = a.sum < T(0) ? -a.sum : a.sum;
+        T abs_b = b.sum < T(0) ? -b.sum : b.sum;
+        T err   = abs_a >= abs_b ? (a.sum - t) + b.sum
+                                 : (b.sum - t) + a.sum;
+        T carry = a.carry + b.carry + err;
+        T sum   = t + carry;
+        return compensated_sum<T>{sum, carry - (sum - t)};
+    }
+};
+
+
+/// \brief Sum up vector elements on device with compensated summation
+template <typename T>
+T run_sum_compensated(thrust::device_vector<T> &X) {
+
+    auto result =
+    thrust::transform_reduce(
+        gpuutils::policy(),
+        X.begin(), X.end(),                 // InputIterator  begin, InputIterator end
+        to_compensated<T>(),                // UnaryFunction  unary_op
+        compensated_sum<T>{T(0), T(0)},     // OutputType     init
+        neumaier_plus<T>()                  // BinaryFunction binary_op
+    );
+
+    return result.sum + result.carry;
+}
+
+
+/// \brief Traffic of run_sum_compensated, 8 FLOPs per neumaier_plus
+template <typename T>
+benchutils::Traffic traffic_sum_compensated(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 0, 8);
+}
+
+
+/// \brief A functor for computing the block index of an item, f(i) -> i / B
+struct block_index {
+
+    size_t block;
+
+    __host__ __device__
+    size_t operator()(size_t i) const {
+        return i / block;
+    }
+};
+
+
+/// \brief Sum up vector elements on device block by block
+/// \details Each pass reduces blocks of `block` items to partial sums, so
+///          no item is accumulated into a running sum longer than one block
+///          and the rounding error grows with log(N) instead of N.
+template <typename T>
+T run_sum_pairwise(thrust::device_vector<T> &X, size_t block = 1024) {
+
+    auto keys = thrust::make_transform_iterator(
+                    thrust::make_counting_iterator<size_t>(0),
+                    block_index{block});
+
+    gpuutils::temporary_vector<T> partials((X.size() + block - 1) / block);
+
+    thrust::reduce_by_key(gpuutils::policy(), keys, keys + X.size(), X.begin(),
+                          thrust::make_discard_iterator(), partials.begin());
+
+    // Reduce partial sums until a single one is left
+    while (partials.size() > 1) {
+        auto n_partials = (partials.size() + block - 1) / block;
+        gpuutils::temporary_vector<T> next(n_partials);
+
+        thrust::reduce_by_key(gpuutils::policy(),
+                              keys, keys + partials.size(), partials.begin(),
+                              thrust::make_discard_iterator(), next.begin());
+
+        partials.swap(next);
+    }
+
+    return partials.empty() ? T(0) : T(partials[0]);
+}
+
+
+/// \brief Traffic of run_sum_pairwise
+/// \details Every level reads its items and writes one partial sum per
+///          block; keys are computed and not read.
+template <typename T>
+benchutils::Traffic traffic_sum_pairwise(size_t n, size_t block = 1024) {
+
+    benchutils::Traffic traffic;
+    do {
+        auto n_partials = (n + block - 1) / block;
+        traffic += benchutils::Traffic::items(n, sizeof(T), 1, 0, 1)
+                 + benchutils::Traffic::items(n_partials, sizeof(T), 0, 1);
+        n = n_partials;
+    } while (n > 1);
+
+    return traffic;
+}
+
+
+///----------------------------------------------------------------------------
+/// Generated inputs
+///----------------------------------------------------------------------------
+
+/// \brief Sum up n items of an input iterator on device
+/// \details The iterator is a vector iterator, or a fancy iterator computing
+///          items from their index so that the input is never stored.
+template <typename T, typename Iterator>
+T run_sum_input(Iterator first, size_t n) {
+    return thrust::reduce(gpuutils::policy(),
+                          first, first + n, T(0), thrust::plus<T>());
+}
+
+
+/// \brief Traffic of run_sum_input for a generated input, one addition
+template <typename T>
+benchutils::Traffic traffic_sum_generated(size_t n) {
+    return benchutils::Traffic::items(n, sizeof(T), 0, 0, 1);
+}
+
+
+///----------------------------------------------------------------------------
+/// Batched small problems
+///----------------------------------------------------------------------------
+
+/// \brief Sum up many vectors stored in a flat buffer, one reduce_by_key
+/// \param X       Items of all vectors
+/// \param offsets Offsets of vectors in X, n_vectors + 1 items
+/// \param sums    Sums of vectors, n_vectors items
+template <typename T>
+void run_sum_batched(thrust::device_vector<T> &X,
+                     thrust::device_vector<size_t> &offsets,
+                     thrust::device_vector<T> &sums) {
+    benchutils::reduce_segments(X.begin(), offsets, sums);
+}
+
+
+/// \brief Traffic of run_sum_batched, read X, write segment ids and sums
+template <typename T>
+benchutils::Traffic traffic_sum_batched(size_t n, size_t n_vectors) {
+    return benchutils::Traffic::items(n, sizeof(T), 1, 0, 1)
+         + benchutils::Traffic::items(n_vectors, sizeof(T) + sizeof(size_t),
+                                      0, 1);
+}
+
+
+///----------------------------------------------------------------------------
+/// Host/device dispatch
+///----------------------------------------------------------------------------
+
+/// \brief Sum up host vector elements with the host system
+template <typename T>
+T host_sum(const thrust::host_vector<T> &X) {
+    return thrust::reduce(thrust::host,
+                          X.begin(), X.end(), (T)0, thrust::plus<T>());
+}
+
+
+/// \brief Sum up host vector elements on device, copy included
+template <typename T>
+T device_sum(const thrust::host_vector<T> &X) {
+    thrust::device_vector<T> dev_X(X);
+    return run_sum(dev_X);
+}
+
+
+/// \brief Get the size from which dispatch_sum runs on device
+template <typename T>
+size_t sum_crossover() {
+    static const size_t crossover = benchutils::crossover(
+        benchutils::tuningKey<T>("sum"),
+        [](size_t n) { return thrust::host_vector<T>(n, T(1)); },
+        [](thrust::host_vector<T> &X) {
+            benchmark::DoNotOptimize(host_sum(X));
+        },
+        [](thrust::host_vector<T> &X) {
+            benchmark::DoNotOptimize(device_sum(X));
+        });
+
+    return crossover;
+}
+
+
+/// \brief Sum up host vector elements on host below the crossover size
+template <typename T>
+T dispatch_sum(const thrust::host_vector<T> &X) {
+    return X.size() < sum_crossover<T>() ? host_sum(X) : device_sum(X);
+}
+
+
+///----------------------------------------------------------------------------
+/// Out-of-core streaming
+///----------------------------------------------------------------------------
+
+/// \brief Sum up host vector elements on device, chunk by chunk
+template <typename T>
+T run_sum_streaming(gpuutils::StreamingReducer<T> &reducer,
+                    const thrust::host_vector<T> &X) {
+    return reducer.transformReduce(X.begin(), X.end(), thrust::identity<T>(),
+                                   T(0), thrust::plus<T>());
+}
+
+
+/// \brief Sum up n items of pinned host memory on device, chunk by chunk,
+///        copied with no staging
+template <typename T>
+T run_sum_streaming(gpuutils::StreamingReducer<T> &reducer,
+                    const T *X, size_t n) {
+    return reducer.transformReducePinned(X, X + n, thrust::identity<T>(),
+                                         T(0), thrust::plus<T>());
+}
+
+
+/// \brief Traffic of run_sum_streaming, copy X to device and read it,
+///        one addition per item
+template <typename T>
+benchutils::Traffic traffic_sum_streaming(size_t n) {
+    return benchutils::Traffic::transfer(n, sizeof(T))
+         + benchutils::Traffic::items(n, sizeof(T), 1, 0, 1);
 }
 
 
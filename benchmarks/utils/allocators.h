@@ -0,0 +1,246 @@
+#ifndef THRUST_BENCHMARKS_ALLOCATORS_H_
+#define THRUST_BENCHMARKS_ALLOCATORS_H_
+
+#include <thrust/device_malloc_allocator.h>
+#include <thrust/device_ptr.h>
+#include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
+#ifdef USE_HIP
+#include <thrust/system/hip/execution_policy.h>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/gpu_utils.h"    /* timingStream */
+
+
+namespace gpuutils {
+
+
+/// \brief Counters of an allocator
+struct AllocatorStats {
+    uint64_t allocations        = 0;    ///< Calls to allocate
+    uint64_t cache_hits         = 0;    ///< Allocations served from the cache
+    uint64_t device_allocations = 0;    ///< Allocations passed to the device
+    size_t   bytes_in_use       = 0;    ///< Bytes handed out and not returned
+    size_t   peak_bytes_in_use  = 0;    ///< Highest bytes_in_use since reset
+    size_t   bytes_cached       = 0;    ///< Bytes kept in free lists
+};
+
+
+/// \brief Counters of device memory of tracked vectors
+struct MemoryStats {
+    uint64_t allocations = 0;   ///< Device allocations since reset
+    size_t   bytes_live  = 0;   ///< Bytes allocated and not freed
+    size_t   bytes_peak  = 0;   ///< Highest bytes_live since reset
+};
+
+
+///-----------------------------------------------------------------------------
+/// \class MemoryTracker
+/// \brief Current and peak bytes of device memory
+/// \details TrackingAllocator reports every device allocation and free, so
+///          that the inputs of a benchmark are known without querying the
+///          device. Temporaries are counted by their own allocator.
+///-----------------------------------------------------------------------------
+class MemoryTracker {
+
+public:
+
+    void allocated(size_t bytes);
+
+    void freed(size_t bytes);
+
+    MemoryStats stats() const;
+
+    /// \brief Reset the peak to the live bytes and the allocation count
+    void resetPeak();
+
+private:
+
+    MemoryStats _stats;
+
+    mutable std::mutex _mutex;
+};
+
+
+/// \brief Get the tracker of device memory of all tracked vectors
+MemoryTracker& deviceMemory();
+
+
+///-----------------------------------------------------------------------------
+/// \class CachingAllocator
+/// \brief A device memory allocator keeping freed blocks for reuse
+/// \details Requests are rounded up to a power of two and freed blocks are
+///          kept in one free list per size class. It satisfies the thrust
+///          allocator interface for temporary storage, so it can be passed
+///          to algorithms via thrust::device(alloc). With caching disabled,
+///          every call goes to the device and is only counted.
+///-----------------------------------------------------------------------------
+class CachingAllocator {
+
+public:
+
+    using value_type = char;
+
+    explicit CachingAllocator(bool caching = false);
+
+    ~CachingAllocator();
+
+    CachingAllocator(const CachingAllocator&) = delete;
+    CachingAllocator& operator=(const CachingAllocator&) = delete;
+
+    /// \brief Allocate a block of at least n bytes
+    char* allocate(std::ptrdiff_t n);
+
+    /// \brief Return a block to the cache, or to the device if not caching
+    void deallocate(char *ptr, size_t n);
+
+    /// \brief Free all cached blocks
+    void release();
+
+    /// \brief Enable or disable caching, disabling releases cached blocks
+    void setCaching(bool caching);
+
+    bool caching() const { return _caching; }
+
+    /// \brief Get counters
+    AllocatorStats stats() const;
+
+    /// \brief Reset counters of calls and the peak, byte counts are kept
+    void resetStats();
+
+    /// \brief Reset the peak of bytes in use to the bytes in use
+    void resetPeak();
+
+private:
+
+    ///< Smallest size class, 512 B
+    static constexpr size_t _min_block = 512;
+
+    /// \brief Round a request up to its size class
+    static size_t blockSize(size_t n);
+
+    /// \brief Free all cached blocks, the caller holds the lock
+    void freeCachedBlocks();
+
+    bool _caching;
+
+    ///< Free lists, size class -> blocks
+    std::map<size_t, std::vector<char*>> _free_blocks;
+
+    ///< Blocks in use, pointer -> size class
+    std::unordered_map<char*, size_t> _live_blocks;
+
+    AllocatorStats _stats;
+
+    mutable std::mutex _mutex;
+};
+
+
+/// \brief Get the allocator used for temporaries of all run_* functions
+CachingAllocator& temporaryAllocator();
+
+
+/// \brief  Get the execution policy used by all run_* functions
+/// \return thrust::device with temporaries from temporaryAllocator(), on
+///         timingStream() for HIP
+#ifdef USE_HIP
+inline auto policy()
+    -> decltype(thrust::hip::par(temporaryAllocator()).on(timingStream())) {
+    return thrust::hip::par(temporaryAllocator()).on(timingStream());
+}
+#else
+inline auto policy() -> decltype(thrust::device(temporaryAllocator())) {
+    return thrust::device(temporaryAllocator());
+}
+#endif
+
+
+///-----------------------------------------------------------------------------
+/// \class TemporaryAllocator
+/// \brief A typed allocator for device vectors backed by temporaryAllocator()
+///-----------------------------------------------------------------------------
+template <typename T>
+struct TemporaryAllocator : thrust::device_malloc_allocator<T> {
+
+    using super_t   = thrust::device_malloc_allocator<T>;
+    using pointer   = typename super_t::pointer;
+    using size_type = typename super_t::size_type;
+
+    template <typename U>
+    struct rebind {
+        using other = TemporaryAllocator<U>;
+    };
+
+    TemporaryAllocator() = default;
+
+    template <typename U>
+    TemporaryAllocator(const TemporaryAllocator<U>&) {}
+
+    pointer allocate(size_type n) {
+        auto ptr = temporaryAllocator().allocate(n * sizeof(T));
+        return pointer(reinterpret_cast<T*>(ptr));
+    }
+
+    void deallocate(pointer ptr, size_type n) {
+        auto raw_ptr = reinterpret_cast<char*>(thrust::raw_pointer_cast(ptr));
+        temporaryAllocator().deallocate(raw_ptr, n * sizeof(T));
+    }
+};
+
+
+///< Device vector for temporaries inside run_* functions
+template <typename T>
+using temporary_vector = thrust::device_vector<T, TemporaryAllocator<T>>;
+
+
+///-----------------------------------------------------------------------------
+/// \class TrackingAllocator
+/// \brief A typed device allocator counting its memory in deviceMemory()
+/// \details Memory comes from the device directly, as with the default
+///          allocator of device_vector, and is never cached.
+///-----------------------------------------------------------------------------
+template <typename T>
+struct TrackingAllocator : thrust::device_malloc_allocator<T> {
+
+    using super_t   = thrust::device_malloc_allocator<T>;
+    using pointer   = typename super_t::pointer;
+    using size_type = typename super_t::size_type;
+
+    template <typename U>
+    struct rebind {
+        using other = TrackingAllocator<U>;
+    };
+
+    TrackingAllocator() = default;
+
+    template <typename U>
+    TrackingAllocator(const TrackingAllocator<U>&) {}
+
+    pointer allocate(size_type n) {
+        auto ptr = super_t::allocate(n);
+        deviceMemory().allocated(n * sizeof(T));
+        return ptr;
+    }
+
+    void deallocate(pointer ptr, size_type n) {
+        super_t::deallocate(ptr, n);
+        deviceMemory().freed(n * sizeof(T));
+    }
+};
+
+
+///< Device vector for inputs of benchmarks, counted in deviceMemory()
+template <typename T>
+using tracked_vector = thrust::device_vector<T, TrackingAllocator<T>>;
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_ALLOCATORS_H_
@@ -0,0 +1,183 @@
+#include <thrust/device_malloc.h>
+#include <thrust/device_free.h>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+#include "allocators.h"
+#include "options.h"
+
+
+namespace gpuutils {
+
+
+void MemoryTracker::allocated(size_t bytes) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.allocations;
+    _stats.bytes_live += bytes;
+    _stats.bytes_peak  = std::max(_stats.bytes_peak, _stats.bytes_live);
+}
+
+
+void MemoryTracker::freed(size_t bytes) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.bytes_live -= bytes;
+}
+
+
+MemoryStats MemoryTracker::stats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+
+void MemoryTracker::resetPeak() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.allocations = 0;
+    _stats.bytes_peak  = _stats.bytes_live;
+}
+
+
+MemoryTracker& deviceMemory() {
+    // Never destroyed, so that memory can still be freed at exit
+    static auto tracker = new MemoryTracker();
+    return *tracker;
+}
+
+
+CachingAllocator::CachingAllocator(bool caching)
+    : _caching(caching) {}
+
+
+CachingAllocator::~CachingAllocator() {
+    release();
+}
+
+
+size_t CachingAllocator::blockSize(size_t n) {
+    size_t size = _min_block;
+    while (size < n)
+        size <<= 1;
+    return size;
+}
+
+
+char* CachingAllocator::allocate(std::ptrdiff_t n) {
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    ++_stats.allocations;
+
+    auto size = _caching ? blockSize(n) : size_t(n);
+
+    // Reuse a cached block of the same size class
+    auto it = _free_blocks.find(size);
+    if (it != _free_blocks.end() && !it->second.empty()) {
+        auto ptr = it->second.back();
+        it->second.pop_back();
+
+        ++_stats.cache_hits;
+        _stats.bytes_cached -= size;
+        _stats.bytes_in_use += size;
+        _stats.peak_bytes_in_use =
+            std::max(_stats.peak_bytes_in_use, _stats.bytes_in_use);
+        _live_blocks[ptr]    = size;
+        return ptr;
+    }
+
+    // Allocate a new block, dropping the cache if the device is full
+    char *ptr = nullptr;
+    try {
+        ptr = thrust::raw_pointer_cast(thrust::device_malloc<char>(size));
+    }
+    catch (const std::bad_alloc&) {
+        freeCachedBlocks();
+        ptr = thrust::raw_pointer_cast(thrust::device_malloc<char>(size));
+    }
+
+    ++_stats.device_allocations;
+    _stats.bytes_in_use += size;
+    _stats.peak_bytes_in_use =
+        std::max(_stats.peak_bytes_in_use, _stats.bytes_in_use);
+    _live_blocks[ptr]    = size;
+    return ptr;
+}
+
+
+void CachingAllocator::deallocate(char *ptr, size_t) {
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _live_blocks.find(ptr);
+    if (it == _live_blocks.end())
+        throw std::invalid_argument("CachingAllocator: unknown block");
+
+    auto size = it->second;
+    _live_blocks.erase(it);
+    _stats.bytes_in_use -= size;
+
+    if (_caching) {
+        _free_blocks[size].push_back(ptr);
+        _stats.bytes_cached += size;
+    }
+    else {
+        thrust::device_free(thrust::device_pointer_cast(ptr));
+    }
+}
+
+
+void CachingAllocator::freeCachedBlocks() {
+
+    for (auto &p : _free_blocks)
+        for (auto block : p.second)
+            thrust::device_free(thrust::device_pointer_cast(block));
+
+    _free_blocks.clear();
+    _stats.bytes_cached = 0;
+}
+
+
+void CachingAllocator::release() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    freeCachedBlocks();
+}
+
+
+void CachingAllocator::setCaching(bool caching) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!caching)
+        freeCachedBlocks();
+    _caching = caching;
+}
+
+
+AllocatorStats CachingAllocator::stats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+
+void CachingAllocator::resetStats() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.allocations        = 0;
+    _stats.cache_hits         = 0;
+    _stats.device_allocations = 0;
+    _stats.peak_bytes_in_use  = _stats.bytes_in_use;
+}
+
+
+void CachingAllocator::resetPeak() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stats.peak_bytes_in_use = _stats.bytes_in_use;
+}
+
+
+CachingAllocator& temporaryAllocator() {
+    // Never destroyed, so that blocks can still be returned at exit
+    static auto allocator =
+        new CachingAllocator(benchutils::options().caching_allocator);
+    return *allocator;
+}
+
+
+}   // namespace
@@ -0,0 +1,67 @@
+#ifndef THRUST_BENCHMARKS_COLD_START_H_
+#define THRUST_BENCHMARKS_COLD_START_H_
+
+#include <functional>
+#include <string>
+
+
+namespace benchutils {
+
+
+/// \brief Phases of the first call to a run_* function in a fresh process
+/// \details Seconds, from the spawn of the process to the first result.
+struct ColdStartTimes {
+    double startup      = 0;    ///< Spawn to main: loading, static init
+    double runtime_init = 0;    ///< Runtime initialization, context creation
+    double first_alloc  = 0;    ///< First device allocation
+    double setup        = 0;    ///< Allocating and filling inputs
+    double first_call   = 0;    ///< First call, first kernel launches
+    double steady_call  = 0;    ///< Fastest of the following calls
+
+    /// \brief Time from the spawn of the process to the first result
+    double firstResult() const {
+        return startup + runtime_init + first_alloc + setup + first_call;
+    }
+};
+
+
+/// \brief A function allocating inputs and returning the call to time
+using ColdStartSetup = std::function<std::function<void()>()>;
+
+
+/// \brief Register a run_* function for --cold_start
+/// \return Number of registered functions
+int registerColdStart(const std::string &name, ColdStartSetup setup);
+
+
+/// \brief Time the first calls to the registered run_* functions
+/// \details Spawns options().cold_start processes per function matching
+///          options().cold_start_filter, each running a single sample, and
+///          prints the median of every phase. Processes are spawned before
+///          this one touches the device.
+/// \param program Path of this executable, argv[0]
+/// \return Exit status of the suite
+int runColdStart(const char *program);
+
+
+/// \brief Run the sample options().cold_start_sample in this process
+/// \details Prints the phases as a single line for the driver.
+/// \return Exit status of the process
+int runColdStartSample();
+
+
+}   // namespace
+
+
+#define COLD_START_CONCAT_(a, b) a##b
+#define COLD_START_CONCAT(a, b)  COLD_START_CONCAT_(a, b)
+
+/// \brief Register a run_* function for --cold_start, at namespace scope
+/// \param name  Name of the sample
+/// \param ...   ColdStartSetup, allocating inputs and returning the call
+#define COLD_START(name, ...)                                               \
+    static int COLD_START_CONCAT(_cold_start_, __LINE__) =                  \
+        benchutils::registerColdStart(name, __VA_ARGS__)
+
+
+#endif  // THRUST_BENCHMARKS_COLD_START_H_
@@ -0,0 +1,214 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "allocators.h"
+#include "cold_start.h"
+#include "gpu_utils.h"
+#include "options.h"
+
+
+namespace benchutils {
+
+///< Bytes of the first allocation, 1 MiB
+static const size_t _first_alloc = size_t(1) << 20;
+
+///< Calls timed after the first one
+static const int _steady_calls = 3;
+
+
+/// \brief Get the registered samples, name -> setup
+static std::map<std::string, ColdStartSetup>& registry() {
+    static std::map<std::string, ColdStartSetup> samples;
+    return samples;
+}
+
+
+int registerColdStart(const std::string &name, ColdStartSetup setup) {
+    registry()[name] = setup;
+    return int(registry().size());
+}
+
+
+/// \brief Get the steady clock in nanoseconds, the same in every process
+static long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/// \brief Time a function with the wall clock up to a device synchronization
+template <typename F>
+static double timeIt(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    gpuutils::deviceSynchronize();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+
+int runColdStartSample() {
+
+    auto start = nowNs();
+    auto &name = options().cold_start_sample;
+
+    auto it = registry().find(name);
+    if (it == registry().end()) {
+        std::fprintf(stderr, "Unknown cold-start sample %s\n", name.c_str());
+        return 1;
+    }
+
+    ColdStartTimes times;
+    times.startup = (start - std::stoll(options().cold_start_t0)) * 1e-9;
+
+    times.runtime_init = timeIt([] { gpuutils::initRuntime(); });
+    times.first_alloc  = timeIt([] {
+        auto &allocator = gpuutils::temporaryAllocator();
+        allocator.deallocate(allocator.allocate(_first_alloc), _first_alloc);
+    });
+
+    std::function<void()> call;
+    times.setup      = timeIt([&] { call = it->second(); });
+    times.first_call = timeIt(call);
+
+    times.steady_call = timeIt(call);
+    for (int i = 1; i < _steady_calls; ++i)
+        times.steady_call = std::min(times.steady_call, timeIt(call));
+
+    gpuutils::waitWarmUp();
+
+    std::printf("%.9f %.9f %.9f %.9f %.9f %.9f\n",
+                times.startup, times.runtime_init, times.first_alloc,
+                times.setup, times.first_call, times.steady_call);
+    return 0;
+}
+
+
+/// \brief Spawn a process running one sample and read its phases
+/// \details The process runs this executable again, program is its argv[0].
+static ColdStartTimes spawnSample(const char *program,
+                                  const std::string &name) {
+
+    int fds[2];
+    if (pipe(fds) != 0)
+        throw std::runtime_error("Failed to create a pipe");
+
+    auto sample = "--cold_start_sample=" + name;
+    auto t0     = "--cold_start_t0=" + std::to_string(nowNs());
+
+    std::vector<std::string> args = {program, sample, t0};
+    if (options().eager_init)
+        args.push_back("--eager_init");
+    if (options().caching_allocator)
+        args.push_back("--caching_allocator");
+
+    pid_t pid = fork();
+    if (pid < 0)
+        throw std::runtime_error("Failed to spawn a cold-start process");
+
+    if (pid == 0) {
+        std::vector<char*> argv;
+        for (auto &arg : args)
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execv("/proc/self/exe", argv.data());
+        std::_Exit(127);
+    }
+
+    close(fds[1]);
+
+    std::string output;
+    char buffer[256];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+        output.append(buffer, n);
+    close(fds[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+
+    ColdStartTimes times;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0
+        || std::sscanf(output.c_str(), "%lf %lf %lf %lf %lf %lf",
+                       &times.startup, &times.runtime_init,
+                       &times.first_alloc, &times.setup,
+                       &times.first_call, &times.steady_call) != 6)
+        throw std::runtime_error("Cold-start sample " + name + " failed");
+
+    return times;
+}
+
+
+/// \brief Get the median of the values of a phase, in milliseconds
+template <typename F>
+static double medianMs(const std::vector<ColdStartTimes> &samples, F phase) {
+    std::vector<double> values;
+    for (auto &s : samples)
+        values.push_back(phase(s));
+    std::sort(values.begin(), values.end());
+
+    size_t m = values.size() / 2;
+    double median = values.size() % 2
+                  ? values[m] : (values[m - 1] + values[m]) / 2;
+    return median * 1e3;
+}
+
+
+int runColdStart(const char *program) {
+
+    std::regex filter(options().cold_start_filter);
+
+    std::printf("Cold start, median of %d processes, milliseconds%s\n\n",
+                options().cold_start,
+                options().eager_init ? ", eager init" : "");
+    std::printf("%-28s %8s %8s %8s %8s %8s %8s %8s\n", "function",
+                "startup", "init", "alloc", "setup", "first", "steady",
+                "result");
+
+    for (auto &entry : registry()) {
+        if (!std::regex_search(entry.first, filter))
+            continue;
+
+        std::vector<ColdStartTimes> samples;
+        try {
+            for (int i = 0; i < options().cold_start; ++i)
+                samples.push_back(spawnSample(program, entry.first));
+        }
+        catch (const std::runtime_error &e) {
+            std::fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+
+        using T = const ColdStartTimes&;
+        std::printf(
+            "%-28s %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+            entry.first.c_str(),
+            medianMs(samples, [](T t) { return t.startup; }),
+            medianMs(samples, [](T t) { return t.runtime_init; }),
+            medianMs(samples, [](T t) { return t.first_alloc; }),
+            medianMs(samples, [](T t) { return t.setup; }),
+            medianMs(samples, [](T t) { return t.first_call; }),
+            medianMs(samples, [](T t) { return t.steady_call; }),
+            medianMs(samples, [](T t) { return t.firstResult(); }));
+        std::fflush(stdout);
+    }
+
+    return 0;
+}
+
+
+}   // namespace
@@ -0,0 +1,189 @@
+#ifndef THRUST_BENCHMARKS_COUNTERS_H_
+#define THRUST_BENCHMARKS_COUNTERS_H_
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "utils/allocators.h"   /* temporaryAllocator, deviceMemory */
+#include "utils/gpu_utils.h"    /* deviceMemoryUsed */
+#include "utils/traffic.h"      /* Traffic, peakBandwidth */
+
+
+namespace benchutils {
+
+
+/// \brief Reset counters of the temporary allocator before timing
+inline void resetAllocatorCounters() {
+    gpuutils::temporaryAllocator().resetStats();
+}
+
+
+/// \brief Report counters of the temporary allocator
+/// \details allocs and device_allocs are per call, bytes_cached is the size
+///          of the cache at the end of the benchmark.
+/// \param state Benchmark state
+/// \param batch Calls to the run_* function per iteration
+inline void setAllocatorCounters(benchmark::State &state, int batch = 1) {
+
+    auto stats = gpuutils::temporaryAllocator().stats();
+
+    state.counters["allocs"] =
+        benchmark::Counter(double(stats.allocations) / batch,
+                           benchmark::Counter::kAvgIterations);
+    state.counters["device_allocs"] =
+        benchmark::Counter(double(stats.device_allocations) / batch,
+                           benchmark::Counter::kAvgIterations);
+    state.counters["bytes_cached"] =
+        benchmark::Counter(double(stats.bytes_cached),
+                           benchmark::Counter::kDefaults,
+                           benchmark::Counter::kIs1024);
+}
+
+
+/// \brief Device memory of a benchmark when its timing starts
+struct MemoryWindow {
+    size_t   baseline     = 0;  ///< Memory in use when the suite starts
+    size_t   untracked    = 0;  ///< Memory not from the suite's allocators
+    uint64_t temp_allocs  = 0;  ///< Temporary allocations so far
+    double   items        = 0;  ///< Items of the traffic model, 0 if none
+};
+
+
+/// \brief Get the memory window of the running benchmark
+inline MemoryWindow& memoryWindow() {
+    static MemoryWindow window;
+    return window;
+}
+
+
+/// \brief Record the memory in use before any benchmark runs
+inline void setMemoryBaseline() {
+    memoryWindow().baseline = gpuutils::deviceMemoryUsed();
+}
+
+
+/// \brief Start measuring the memory footprint, inputs allocated
+/// \details Peaks of tracked vectors and of temporaries are reset. Memory
+///          in use that neither tracked vectors nor temporaryAllocator()
+///          hold, inputs in plain device_vector mostly, is recorded for the
+///          fallback estimate. With HIP the memory in use is device-wide,
+///          so memory of other processes on the device counts as well.
+inline void startMemoryCounters() {
+
+    auto &window = memoryWindow();
+    auto used    = gpuutils::deviceMemoryUsed();
+    auto inputs  = gpuutils::deviceMemory().stats().bytes_live;
+    auto temp    = gpuutils::temporaryAllocator().stats();
+    auto known   = inputs + temp.bytes_in_use + temp.bytes_cached;
+
+    used -= std::min(used, window.baseline);
+    window.untracked   = used > known ? used - known : 0;
+    window.temp_allocs = temp.allocations;
+    window.items       = 0;
+
+    gpuutils::deviceMemory().resetPeak();
+    gpuutils::temporaryAllocator().resetPeak();
+}
+
+
+/// \brief Report the memory footprint since startMemoryCounters()
+/// \details device_peak is the peak of tracked vectors plus the peak of
+///          temporaries handed out by temporaryAllocator(), temp_peak the
+///          latter alone and temp_allocs the temporary allocations per
+///          iteration. Cached blocks are not counted, so the counters do not
+///          depend on earlier benchmarks. Benchmarks without tracked vectors
+///          report device_peak_estimate and bytes_per_item_estimate instead,
+///          from the untracked memory in use when timing started.
+/// \param state Benchmark state
+/// \param items Items of the benchmark, for bytes_per_item, 0 to skip it
+inline void setMemoryCounters(benchmark::State &state, double items) {
+
+    auto &window = memoryWindow();
+    auto inputs  = gpuutils::deviceMemory().stats();
+    auto temp    = gpuutils::temporaryAllocator().stats();
+
+    // Counters of calls reset by resetAllocatorCounters() in between
+    auto allocs = temp.allocations >= window.temp_allocs
+                ? temp.allocations - window.temp_allocs : temp.allocations;
+    auto peak   = double(inputs.bytes_peak + temp.peak_bytes_in_use);
+
+    // Without tracked vectors, inputs are only seen by the device
+    std::string suffix;
+    if (inputs.bytes_peak == 0) {
+        peak  += double(window.untracked);
+        suffix = "_estimate";
+    }
+
+    state.counters["device_peak" + suffix] =
+        benchmark::Counter(peak, benchmark::Counter::kDefaults,
+                           benchmark::Counter::kIs1024);
+    state.counters["temp_peak"] =
+        benchmark::Counter(double(temp.peak_bytes_in_use),
+                           benchmark::Counter::kDefaults,
+                           benchmark::Counter::kIs1024);
+    state.counters["temp_allocs"] =
+        benchmark::Counter(double(allocs),
+                           benchmark::Counter::kAvgIterations);
+    if (items > 0)
+        state.counters["bytes_per_item" + suffix] = peak / items;
+}
+
+
+/// \brief Report bytes processed and roofline counters
+/// \details bandwidth and flops are rates over the real time, intensity is
+///          FLOPs per byte and peak% compares the achieved bandwidth with
+///          peakBandwidth(). transfer is the rate of bytes between host and
+///          device, which have no peak%. Bytes processed count both. Console
+///          output appends /s to all rates. The items of the largest pass
+///          of the traffic model are kept for the memory counters that the
+///          timer reports, so call it before the timer's setCounters().
+///          For traffic moved in one phase of a PhaseTimer, rates are over
+///          the time of the phase instead. They are then plain values, with
+///          no /s on the console, and bytes processed are left to the
+///          caller, so that phases can report their own traffic.
+/// \param state   Benchmark state
+/// \param traffic Traffic of a single iteration
+/// \param seconds Time of the phase summed over iterations, 0 for the
+///                real time
+inline void setTrafficCounters(benchmark::State &state,
+                               const Traffic &traffic, double seconds = 0) {
+
+    auto iterations = double(state.iterations());
+    auto bytes      = iterations * traffic.bytes();
+    auto transfers  = iterations * traffic.transfers;
+
+    // Totals over the real time, or rates over the time of the phase
+    auto flags = benchmark::Counter::kIsRate;
+    auto scale = 1.;
+    if (seconds > 0) {
+        flags = benchmark::Counter::kDefaults;
+        scale = 1 / seconds;
+    }
+    else {
+        state.SetBytesProcessed(int64_t(bytes + transfers));
+    }
+
+    if (traffic.bytes() > 0) {
+        state.counters["bandwidth"] =
+            benchmark::Counter(bytes * scale, flags);
+        state.counters["flops"] =
+            benchmark::Counter(iterations * traffic.flops * scale, flags);
+        state.counters["intensity"] = traffic.intensity();
+        state.counters["peak%"] =
+            benchmark::Counter(bytes * scale * 100 / peakBandwidth(), flags);
+    }
+    if (traffic.transfers > 0)
+        state.counters["transfer"] =
+            benchmark::Counter(transfers * scale, flags);
+
+    auto &items = memoryWindow().items;
+    items = std::max(items, traffic.n_items);
+}
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_COUNTERS_H_
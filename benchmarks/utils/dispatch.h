@@ -0,0 +1,105 @@
+#ifndef THRUST_BENCHMARKS_DISPATCH_H_
+#define THRUST_BENCHMARKS_DISPATCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "utils/gpu_utils.h"    /* deviceName, deviceSynchronize */
+
+
+namespace benchutils {
+
+
+/// \brief Where a dispatched call runs
+enum class Target {
+    host,       ///< thrust::host, the host system (CPP, OMP or TBB)
+    device      ///< run_* functions, input and output copied
+};
+
+
+/// \brief  Get the size from which an operation is faster on device
+/// \details Crossovers are read from options().tuning_file. An unknown
+///          one is calibrated by timing both targets for sizes from 1K to
+///          4M items, and saved to the file.
+/// \param  name Tuning key of the operation, see tuningKey()
+/// \param  time Seconds of a call on n items on a target
+/// \return Smallest size from which the device is faster, SIZE_MAX if
+///         it never is
+size_t crossover(const std::string &name,
+                 const std::function<double(size_t, Target)> &time);
+
+
+/// \brief  Time a call for calibration
+/// \return Seconds of the fastest of a few calls after a warm-up
+template <typename F>
+double timeCall(F &&f, int n_runs = 5) {
+
+    f();
+    gpuutils::deviceSynchronize();
+
+    double best = 0;
+    for (int i = 0; i < n_runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        gpuutils::deviceSynchronize();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        best = i == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+
+    return best;
+}
+
+
+/// \brief  Get the crossover of an operation on vectors
+/// \details For calibration, each target is timed on input(n).
+/// \param  name   Tuning key of the operation, see tuningKey()
+/// \param  input  A function making the input of n items
+/// \param  host   A function running the host implementation on the input
+/// \param  device A function running the device implementation on the input
+template <typename Input, typename Host, typename Device>
+size_t crossover(const std::string &name,
+                 Input input, Host host, Device device) {
+    return crossover(name, [&](size_t n, Target target) {
+        auto X = input(n);
+        if (target == Target::host)
+            return timeCall([&] { host(X); });
+        else
+            return timeCall([&] { device(X); });
+    });
+}
+
+
+/// \brief Get the name of an item type for the tuning file
+template <typename T> const char* typeName();
+template <> inline const char* typeName<float>()   { return "float"; }
+template <> inline const char* typeName<double>()  { return "double"; }
+template <> inline const char* typeName<int32_t>() { return "int32_t"; }
+template <> inline const char* typeName<int64_t>() { return "int64_t"; }
+
+
+/// \brief Get the tuning key of an operation on items of type T
+/// \details Keys name the device and host systems and the current device,
+///          e.g. sum<float>@HIP/CPP/AMD_Instinct_MI210, so that builds and
+///          devices sharing a tuning file keep their own crossovers.
+template <typename T>
+std::string tuningKey(const char *op) {
+    std::string key = std::string(op) + "<" + typeName<T>() + ">@"
+                    + DEVICE_SYSTEM_NAME "/" HOST_SYSTEM_NAME "/"
+                    + gpuutils::deviceName();
+
+    // Fields of the tuning file are separated by spaces
+    std::replace(key.begin(), key.end(), ' ', '_');
+    return key;
+}
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_DISPATCH_H_
@@ -0,0 +1,348 @@
+#ifndef THRUST_BENCHMARKS_GENERATORS_H_
+#define THRUST_BENCHMARKS_GENERATORS_H_
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/device_vector.h>
+#include <thrust/host_vector.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/tabulate.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "utils/dispatch.h"      /* typeName */
+#include "utils/mapped_file.h"   /* MappedFile, dataPath, writeFile */
+#include "utils/options.h"       /* options */
+
+
+namespace benchutils {
+
+
+/// \brief Distributions of generated input data
+enum class Distribution : int {
+    uniform = 0,    ///< Uniformly random values
+    normal,         ///< Normal values, standard deviation param
+    zipf,           ///< Zipf-distributed ranks in [0, 2^20), exponent param
+    sorted_runs,    ///< Ascending runs of param items
+    duplicates      ///< Uniform values, about a ratio param of them repeated
+};
+
+///< Number of data distributions
+constexpr int n_distributions = 5;
+
+
+/// \brief Get the name of a data distribution
+inline const char* distributionName(Distribution dist) {
+    switch (dist) {
+        case Distribution::uniform:       return "uniform";
+        case Distribution::normal:        return "normal";
+        case Distribution::zipf:          return "zipf";
+        case Distribution::sorted_runs:   return "sorted_runs";
+        case Distribution::duplicates:    return "duplicates";
+    }
+    return "unknown";
+}
+
+
+/// \brief Description of a generated data set, without its size and type
+/// \details A param of 0 selects the default of the distribution: standard
+///          deviation 1 (2^20 for integers), Zipf exponent 1, runs of 1024
+///          items, and half of the items duplicated.
+struct DataSpec {
+
+    Distribution dist;
+    uint64_t     seed;
+    double       param;
+
+    DataSpec(Distribution dist = Distribution::uniform, uint64_t seed = 42,
+             double param = 0)
+        : dist(dist), seed(seed), param(param) {}
+};
+
+
+/// \brief Get the parameter of a data set of T, defaults resolved
+template <typename T>
+double dataParameter(const DataSpec &spec) {
+    if (spec.param != 0)
+        return spec.param;
+
+    switch (spec.dist) {
+        case Distribution::normal:
+            return std::is_integral<T>::value ? double(1 << 20) : 1.;
+        case Distribution::zipf:          return 1.;
+        case Distribution::sorted_runs:   return 1024.;
+        case Distribution::duplicates:    return 0.5;
+        default:                          return 0.;
+    }
+}
+
+
+/// \brief Get the parameter of a data set of T, checked for its distribution
+template <typename T>
+double checkedParameter(const DataSpec &spec) {
+    double param = dataParameter<T>(spec);
+    if (spec.dist == Distribution::sorted_runs && param < 1)
+        throw std::invalid_argument("Sorted runs need one item or more");
+    if (spec.dist == Distribution::duplicates && (param < 0 || param >= 1))
+        throw std::invalid_argument("A duplicate ratio must be in [0, 1)");
+    return param;
+}
+
+
+/// \brief Counter-based random bits f(i) -> splitmix64(seed, i)
+/// \details The i-th number depends on i only, so data can be generated
+///          in parallel, in any chunks, and is the same for every size.
+struct hash_bits {
+
+    uint64_t seed;
+
+    __host__ __device__
+    uint64_t operator()(uint64_t i) const {
+        uint64_t z = seed + (i + 1) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+
+
+/// \brief Map random bits to a double in [0, 1)
+__host__ __device__
+inline double bits_to_unit(uint64_t bits) {
+    return (bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+/// \brief Map random bits to a value over the whole range of an integer type
+template <typename T>
+__host__ __device__
+T bits_to_key(uint64_t bits, std::true_type /* is_integral */) {
+    return T(bits);
+}
+
+
+/// \brief Map random bits to a floating-point value in [-1, 1)
+template <typename T>
+__host__ __device__
+T bits_to_key(uint64_t bits, std::false_type /* is_integral */) {
+    return T(2 * bits_to_unit(bits) - 1);
+}
+
+
+/// \brief Map a double in [0, 1) to a non-negative integer, order kept
+template <typename T>
+__host__ __device__
+T unit_to_key(double u, std::true_type /* is_integral */) {
+    return T(std::ldexp(u, std::numeric_limits<T>::digits));
+}
+
+
+/// \brief Map a double in [0, 1) to a floating-point value in [-1, 1)
+template <typename T>
+__host__ __device__
+T unit_to_key(double u, std::false_type /* is_integral */) {
+    return T(2 * u - 1);
+}
+
+
+/// \brief A functor for computing item offset + j of a data set
+/// \details Zipf ranks need a CDF and are drawn by generate() instead.
+template <typename T>
+struct data_generator {
+
+    Distribution dist;
+    hash_bits    bits;
+    hash_bits    extra_bits;
+    double       param;
+    uint64_t     n;         ///< Items of the whole data set
+    uint64_t     offset;    ///< Index of item 0 of the generated range
+
+    __host__ __device__
+    T operator()(uint64_t j) const {
+        uint64_t i = offset + j;
+        auto integral = std::is_integral<T>();
+
+        switch (dist) {
+            case Distribution::normal: {
+                // Box-Muller transform of two draws, u1 in (0, 1]
+                double u1 = 1 - bits_to_unit(bits(i));
+                double u2 = bits_to_unit(extra_bits(i));
+                double z  = std::sqrt(-2 * std::log(u1))
+                          * std::cos(6.283185307179586 * u2);
+                return T(param * z);
+            }
+            case Distribution::sorted_runs: {
+                // A random start in [0, 1/2) plus the position in the run
+                uint64_t run = uint64_t(param);
+                double start = bits_to_unit(bits(i / run));
+                double u     = (start + double(i % run) / run) / 2;
+                return unit_to_key<T>(u, integral);
+            }
+            case Distribution::duplicates: {
+                // Items pick one of n * (1 - ratio) distinct values
+                uint64_t distinct = uint64_t(n * (1 - param));
+                if (distinct == 0)
+                    distinct = 1;
+                return bits_to_key<T>(extra_bits(bits(i) % distinct),
+                                      integral);
+            }
+            default:
+                return bits_to_key<T>(bits(i), integral);
+        }
+    }
+};
+
+
+/// \brief A functor for drawing a uniform number in [0, 1) for item i
+struct unit_generator {
+
+    hash_bits bits;
+
+    __host__ __device__
+    double operator()(uint64_t i) const {
+        return bits_to_unit(bits(i));
+    }
+};
+
+
+///< Iterator over the items of a data set, generated when dereferenced
+template <typename T>
+using data_iterator =
+    thrust::transform_iterator<data_generator<T>,
+                               thrust::counting_iterator<uint64_t>>;
+
+
+/// \brief Get an iterator over the n items of a data set, never materialized
+/// \details Items are the same as the ones of generate(). Zipf ranks need a
+///          CDF in memory and are not supported.
+template <typename T>
+data_iterator<T> dataIterator(const DataSpec &spec, size_t n) {
+
+    if (spec.dist == Distribution::zipf)
+        throw std::invalid_argument("Zipf data cannot be generated on the fly");
+
+    double param = checkedParameter<T>(spec);
+    return thrust::make_transform_iterator(
+               thrust::make_counting_iterator<uint64_t>(0),
+               data_generator<T>{spec.dist, hash_bits{spec.seed},
+                                 hash_bits{~spec.seed}, param, n, 0});
+}
+
+
+/// \brief Fill a vector with items [offset, offset + size) of a data set
+/// \tparam CdfVector Vector of doubles in the system of X, for Zipf ranks
+template <typename CdfVector, typename Vector>
+void generateRange(Vector &X, const DataSpec &spec,
+                   size_t offset, size_t total) {
+
+    using T = typename Vector::value_type;
+
+    double param = checkedParameter<T>(spec);
+
+    if (spec.dist != Distribution::zipf) {
+        thrust::tabulate(X.begin(), X.end(),
+            data_generator<T>{spec.dist, hash_bits{spec.seed},
+                              hash_bits{~spec.seed}, param, total, offset});
+        return;
+    }
+
+    // Zipf ranks invert the CDF with a binary search, built on host
+    const size_t n_ranks = 1 << 20;
+    std::vector<double> cdf(n_ranks);
+    double sum = 0.;
+    for (size_t k = 0; k < n_ranks; ++k) {
+        sum += 1. / std::pow(double(k + 1), param);
+        cdf[k] = sum;
+    }
+    for (auto &c : cdf)
+        c /= sum;
+    cdf.back() = 1.;
+
+    CdfVector system_cdf(cdf.begin(), cdf.end());
+
+    auto uniforms = thrust::make_transform_iterator(
+                        thrust::make_counting_iterator<uint64_t>(offset),
+                        unit_generator{hash_bits{spec.seed}});
+
+    thrust::upper_bound(system_cdf.begin(), system_cdf.end(),
+                        uniforms, uniforms + X.size(), X.begin());
+}
+
+
+/// \brief Fill a device vector with items of a data set, in parallel
+/// \param X      Device vector to fill
+/// \param spec   Distribution, seed and parameter
+/// \param offset Index of the first item, to generate a set in chunks
+/// \param total  Items of the whole set, X.size() if 0
+template <typename T>
+void generate(thrust::device_vector<T> &X, const DataSpec &spec,
+              size_t offset = 0, size_t total = 0) {
+    generateRange<thrust::device_vector<double>>(
+        X, spec, offset, total ? total : X.size());
+}
+
+
+/// \brief Fill a host vector with items of a data set with the host system
+/// \details Items are the same as on device, bit for bit for integers.
+template <typename T>
+void generate(thrust::host_vector<T> &X, const DataSpec &spec,
+              size_t offset = 0, size_t total = 0) {
+    generateRange<thrust::host_vector<double>>(
+        X, spec, offset, total ? total : X.size());
+}
+
+
+/// \brief Get the file name of a data set of n items of T
+/// \details data_<dist>_<param>_<seed>_<n>_<type>.bin
+template <typename T>
+std::string dataName(const DataSpec &spec, size_t n) {
+    std::ostringstream name;
+    name << "data_" << distributionName(spec.dist) << "_"
+         << dataParameter<T>(spec) << "_" << spec.seed << "_" << n << "_"
+         << typeName<T>() << ".bin";
+    return name.str();
+}
+
+
+/// \brief Get a file of n items of a data set, generated on host if missing
+/// \return Path of the file in options().data_dir
+template <typename T>
+std::string dataFile(const DataSpec &spec, size_t n) {
+
+    auto path = dataPath(dataName<T>(spec, n));
+    if (fileSize(path) == n * sizeof(T))
+        return path;
+
+    thrust::host_vector<T> X(n);
+    generate(X, spec);
+    writeFile(path, X.data(), n * sizeof(T));
+    return path;
+}
+
+
+/// \brief Fill a device vector with a data set, read from its file with
+///        --data_cache and generated on device otherwise
+template <typename T>
+void makeData(thrust::device_vector<T> &X, const DataSpec &spec) {
+
+    if (!options().data_cache) {
+        generate(X, spec);
+        return;
+    }
+
+    MappedFile file(dataFile<T>(spec, X.size()));
+    thrust::copy(file.begin<T>(), file.end<T>(), X.begin());
+}
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_GENERATORS_H_
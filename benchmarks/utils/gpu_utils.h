@@ -1,9 +1,20 @@
 #ifndef THRUST_BENCHMARKS_GPU_UTILS_H_
 #define THRUST_BENCHMARKS_GPU_UTILS_H_
 
+#ifdef USE_HIP
+#include <hip/hip_runtime_api.h>    /* hipEvent_t, hipStream_t */
+#else
+#include <chrono>
+#endif
+#include <cstddef>
+#include <string>
+
 
 /// \namespace gpuutils
 /// \brief     Helper functions for retrieving device information.
+/// \details   Calls to the HIP runtime are routed through these functions
+///            so that the benchmarks also build against host device systems
+///            (CPP, OMP, TBB), for which they are no-ops.
 namespace gpuutils {
 
 /// \brief Get the ID of the GPU assigned to current rank.
@@ -14,9 +25,89 @@ int getMyGPU();
 void setMyGPU(int id);
 
 /// \brief  Get the number of available GPUs on this node.
-/// \return Number of GPUs
+/// \return Number of GPUs, 0 for host device systems
 int getNumGPUs();
 
+/// \brief Make a GPU the current device.
+/// \param id Valid GPU ID
+void setDevice(int id);
+
+/// \brief Block until all work submitted to the current device is done.
+void deviceSynchronize();
+
+/// \brief Initialize the runtime and create the context of the current device.
+void initRuntime();
+
+/// \brief Pay the one-time costs of a process: runtime initialization, a
+///        first allocation and a first kernel launch.
+void warmUp();
+
+/// \brief Run warmUp() in a background thread, once per process.
+/// \details Meant for process start, so that the one-time costs overlap
+///          with host work done before the first thrust call.
+void startWarmUp();
+
+/// \brief Wait for the warm-up started by startWarmUp(), if any.
+void waitWarmUp();
+
+/// \brief  Get the memory in use on the current device, by any allocator
+///         of any process
+/// \return Bytes, the resident memory of the process for host device systems
+size_t deviceMemoryUsed();
+
+/// \brief  Get the name of the current device
+/// \return Name reported by the runtime, "host" for host device systems
+std::string deviceName();
+
+#ifdef USE_HIP
+/// \brief Get the stream of the current device on which run_* functions
+///        are launched and timed.
+/// \details Created on first use for each device. It is a blocking stream,
+///          so it is ordered with work on the null stream.
+hipStream_t timingStream();
+
+/// \brief Get the i-th stream of the current device for pipelines
+/// \details Created on first use, non-blocking, so that the stages of a
+///          pipeline overlap with each other.
+hipStream_t pipelineStream(int i);
+#endif
+
+
+///-----------------------------------------------------------------------------
+/// \class EventTimer
+/// \brief Time work submitted to the timing stream of the current device
+/// \details Start and stop events are recorded on timingStream(). Host
+///          device systems run thrust calls synchronously, a steady clock
+///          is used instead.
+///-----------------------------------------------------------------------------
+class EventTimer {
+
+public:
+
+    EventTimer();
+
+    ~EventTimer();
+
+    EventTimer(const EventTimer&) = delete;
+    EventTimer& operator=(const EventTimer&) = delete;
+
+    /// \brief Record the start event
+    void start();
+
+    /// \brief  Record the stop event and wait for it
+    /// \return Seconds elapsed between the events
+    double stop();
+
+private:
+
+#ifdef USE_HIP
+    hipEvent_t _start;
+    hipEvent_t _stop;
+#else
+    std::chrono::steady_clock::time_point _start;
+#endif
+};
+
 }   // namespace
 
 
@@ -1,5 +1,19 @@
+#ifdef USE_HIP
 #include <hip/hip_runtime.h>    /* hipGetDeviceCount */
+#else
+#include <unistd.h>             /* sysconf */
+#endif
+#include <thrust/device_vector.h>
+#include <thrust/functional.h>
+#include <thrust/transform.h>
+#include <cstdio>
+#include <map>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "gpu_utils.h"
 
 
 namespace gpuutils {
@@ -18,10 +32,168 @@ void setMyGPU(int id) {
     _gpu_id = id;
 }
 
+void warmUp() {
+    initRuntime();
+    thrust::device_vector<float> X(1);
+    thrust::device_vector<float> Y(1);
+    thrust::transform(X.begin(), X.end(), Y.begin(), thrust::negate<float>());
+    deviceSynchronize();
+}
+
+///< Thread of startWarmUp(), joined by waitWarmUp()
+static std::thread _warm_up;
+static bool _warm_up_started = false;
+
+void startWarmUp() {
+    if (!_warm_up_started)
+        _warm_up = std::thread(warmUp);
+    _warm_up_started = true;
+}
+
+void waitWarmUp() {
+    if (_warm_up.joinable())
+        _warm_up.join();
+}
+
+#ifdef USE_HIP
+
 int getNumGPUs() {
     int n_gpus;
     hipGetDeviceCount(&n_gpus);
     return n_gpus;
 }
 
+void setDevice(int id) {
+    hipSetDevice(id);
+}
+
+void deviceSynchronize() {
+    hipDeviceSynchronize();
+}
+
+void initRuntime() {
+    // Freeing a null pointer creates the context and does nothing else
+    hipFree(nullptr);
+}
+
+size_t deviceMemoryUsed() {
+    size_t free = 0, total = 0;
+    hipMemGetInfo(&free, &total);
+    return total - free;
+}
+
+std::string deviceName() {
+    int id;
+    hipDeviceProp_t props;
+    hipGetDevice(&id);
+    if (hipGetDeviceProperties(&props, id) != hipSuccess)
+        throw std::runtime_error("Failed to get the device properties");
+    return props.name;
+}
+
+hipStream_t timingStream() {
+    // Streams are never destroyed, they live as long as the devices
+    static std::map<int, hipStream_t> streams;
+
+    int id;
+    hipGetDevice(&id);
+
+    auto it = streams.find(id);
+    if (it == streams.end()) {
+        hipStream_t stream;
+        if (hipStreamCreate(&stream) != hipSuccess)
+            throw std::runtime_error("Failed to create a timing stream");
+        it = streams.emplace(id, stream).first;
+    }
+
+    return it->second;
+}
+
+hipStream_t pipelineStream(int i) {
+    // Streams are never destroyed, they live as long as the devices
+    static std::map<std::pair<int, int>, hipStream_t> streams;
+
+    int id;
+    hipGetDevice(&id);
+
+    auto key = std::make_pair(id, i);
+    auto it  = streams.find(key);
+    if (it == streams.end()) {
+        hipStream_t stream;
+        if (hipStreamCreateWithFlags(&stream, hipStreamNonBlocking)
+                != hipSuccess)
+            throw std::runtime_error("Failed to create a pipeline stream");
+        it = streams.emplace(key, stream).first;
+    }
+
+    return it->second;
+}
+
+EventTimer::EventTimer() {
+    hipEventCreate(&_start);
+    hipEventCreate(&_stop);
+}
+
+EventTimer::~EventTimer() {
+    hipEventDestroy(_start);
+    hipEventDestroy(_stop);
+}
+
+void EventTimer::start() {
+    hipEventRecord(_start, timingStream());
+}
+
+double EventTimer::stop() {
+    hipEventRecord(_stop, timingStream());
+    hipEventSynchronize(_stop);
+
+    float ms = 0;
+    hipEventElapsedTime(&ms, _start, _stop);
+    return ms * 1e-3;
+}
+
+#else   // Host device systems
+
+int getNumGPUs() {
+    return 0;
+}
+
+void setDevice(int) {}
+
+void deviceSynchronize() {}
+
+void initRuntime() {}
+
+size_t deviceMemoryUsed() {
+    // Second field of statm, resident pages
+    size_t pages = 0, resident = 0;
+    std::FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (std::fscanf(statm, "%zu %zu", &pages, &resident) != 2)
+            resident = 0;
+        std::fclose(statm);
+    }
+    return resident * size_t(sysconf(_SC_PAGESIZE));
+}
+
+std::string deviceName() {
+    return "host";
+}
+
+EventTimer::EventTimer() = default;
+
+EventTimer::~EventTimer() = default;
+
+void EventTimer::start() {
+    _start = std::chrono::steady_clock::now();
+}
+
+double EventTimer::stop() {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - _start;
+    return elapsed.count();
+}
+
+#endif  // USE_HIP
+
 }   // namespace
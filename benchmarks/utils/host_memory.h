@@ -0,0 +1,100 @@
+#ifndef THRUST_BENCHMARKS_HOST_MEMORY_H_
+#define THRUST_BENCHMARKS_HOST_MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace gpuutils {
+
+
+/// \brief Kinds of host memory exchanged with the device
+enum class HostMemory : int {
+    pageable = 0,       ///< malloc, staged through pinned buffers by HIP
+    pinned,             ///< hipHostMalloc
+    registered,         ///< malloc, then hipHostRegister
+    mapped,             ///< hipHostMalloc mapped, read and written by kernels
+    managed,            ///< hipMallocManaged, pages migrated on fault
+    managed_prefetch    ///< hipMallocManaged, pages prefetched before use
+};
+
+///< Number of kinds of host memory
+constexpr int n_host_memory_kinds = 6;
+
+
+/// \brief Get the name of a kind of host memory
+const char* hostMemoryName(HostMemory kind);
+
+
+///-----------------------------------------------------------------------------
+/// \class HostBuffer
+/// \brief Host memory of a given kind
+/// \details Host device systems have a single kind of memory, all kinds
+///          are then allocated with malloc and copied with memcpy.
+///-----------------------------------------------------------------------------
+class HostBuffer {
+
+public:
+
+    /// \param bytes Size, a multiple of 8 bytes
+    /// \param kind  Kind of memory
+    HostBuffer(size_t bytes, HostMemory kind);
+
+    ~HostBuffer();
+
+    HostBuffer(const HostBuffer&) = delete;
+    HostBuffer& operator=(const HostBuffer&) = delete;
+
+    /// \brief Get the address of the buffer on host
+    char* data() { return _data; }
+
+    /// \brief Get the address of the buffer in kernels, for direct kinds
+    char* deviceData() { return _device_data; }
+
+    size_t size() const { return _bytes; }
+
+    HostMemory kind() const { return _kind; }
+
+    /// \brief Whether kernels access the buffer in place, mapped and managed
+    bool direct() const;
+
+    /// \brief Whether pages migrate between host and device
+    bool managed() const;
+
+    /// \brief  Read one byte per page on host
+    /// \details Pages of managed memory left on the device migrate back.
+    /// \return Sum of the bytes read
+    uint64_t touch() const;
+
+private:
+
+    size_t     _bytes;
+    HostMemory _kind;
+    char      *_data;
+    char      *_device_data;    ///< Address on device, data() unless mapped
+};
+
+
+/// \brief Copy a host buffer to device memory
+/// \details Pageable, pinned and registered buffers are copied with
+///          hipMemcpyAsync, mapped and managed ones by a kernel reading
+///          them in place, after a prefetch for managed_prefetch. The copy
+///          runs on a stream of its own per direction, so that both
+///          directions overlap; call deviceSynchronize to wait for it.
+/// \param src Host buffer
+/// \param dst Device memory of src.size() bytes
+void copyToDevice(HostBuffer &src, void *dst);
+
+
+/// \brief Copy device memory to a host buffer
+/// \details As copyToDevice, a kernel writes mapped and managed buffers,
+///          and managed_prefetch pages are then prefetched to the host.
+/// \param src Device memory of dst.size() bytes
+/// \param dst Host buffer
+void copyToHost(const void *src, HostBuffer &dst);
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_HOST_MEMORY_H_
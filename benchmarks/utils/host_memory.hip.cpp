@@ -0,0 +1,239 @@
+#ifdef USE_HIP
+#include <hip/hip_runtime.h>    /* hipHostMalloc, hipLaunchKernelGGL */
+#endif
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "host_memory.h"
+
+
+namespace gpuutils {
+
+///< Granularity of touch(), the smallest page size
+static const size_t _page = 4096;
+
+
+const char* hostMemoryName(HostMemory kind) {
+    switch (kind) {
+        case HostMemory::pageable:          return "pageable";
+        case HostMemory::pinned:            return "pinned";
+        case HostMemory::registered:        return "registered";
+        case HostMemory::mapped:            return "mapped";
+        case HostMemory::managed:           return "managed";
+        case HostMemory::managed_prefetch:  return "managed_prefetch";
+    }
+    return "unknown";
+}
+
+
+bool HostBuffer::direct() const {
+    return _kind == HostMemory::mapped || managed();
+}
+
+
+bool HostBuffer::managed() const {
+    return _kind == HostMemory::managed
+        || _kind == HostMemory::managed_prefetch;
+}
+
+
+uint64_t HostBuffer::touch() const {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < _bytes; i += _page)
+        sum += static_cast<volatile char*>(_data)[i];
+    return sum;
+}
+
+
+#ifdef USE_HIP
+
+/// \brief Copy 8-byte words with a grid-stride loop
+__global__
+void copyWords(const uint64_t *src, uint64_t *dst, size_t n) {
+    size_t stride = size_t(gridDim.x) * blockDim.x;
+    for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += stride)
+        dst[i] = src[i];
+}
+
+
+/// \brief Get the copy stream of a direction on the current device
+/// \details Non-blocking, so that copies in both directions overlap.
+static hipStream_t copyStream(bool to_device) {
+    // Streams are never destroyed, they live as long as the devices
+    static std::map<std::pair<int, bool>, hipStream_t> streams;
+
+    int id;
+    hipGetDevice(&id);
+
+    auto key = std::make_pair(id, to_device);
+    auto it  = streams.find(key);
+    if (it == streams.end()) {
+        hipStream_t stream;
+        if (hipStreamCreateWithFlags(&stream, hipStreamNonBlocking)
+                != hipSuccess)
+            throw std::runtime_error("Failed to create a copy stream");
+        it = streams.emplace(key, stream).first;
+    }
+
+    return it->second;
+}
+
+
+/// \brief Copy bytes with a kernel on a stream
+static void copyKernel(const void *src, void *dst, size_t bytes,
+                       hipStream_t stream) {
+    size_t n = bytes / sizeof(uint64_t);
+    hipLaunchKernelGGL(copyWords, dim3(1024), dim3(256), 0, stream,
+                       static_cast<const uint64_t*>(src),
+                       static_cast<uint64_t*>(dst), n);
+}
+
+
+/// \brief Free host memory of a kind
+static void freeHost(HostMemory kind, void *ptr) {
+    switch (kind) {
+        case HostMemory::pageable:
+            std::free(ptr);
+            break;
+        case HostMemory::registered:
+            hipHostUnregister(ptr);
+            std::free(ptr);
+            break;
+        case HostMemory::pinned:
+        case HostMemory::mapped:
+            hipHostFree(ptr);
+            break;
+        case HostMemory::managed:
+        case HostMemory::managed_prefetch:
+            hipFree(ptr);
+            break;
+    }
+}
+
+
+HostBuffer::HostBuffer(size_t bytes, HostMemory kind)
+    : _bytes(bytes), _kind(kind), _data(nullptr), _device_data(nullptr) {
+
+    if (bytes % sizeof(uint64_t) != 0)
+        throw std::invalid_argument("Host buffers must hold 8-byte words");
+
+    hipError_t status = hipSuccess;
+    void *ptr = nullptr;
+
+    switch (kind) {
+        case HostMemory::pageable:
+            ptr = std::malloc(bytes);
+            break;
+        case HostMemory::pinned:
+            status = hipHostMalloc(&ptr, bytes, hipHostMallocDefault);
+            break;
+        case HostMemory::registered:
+            ptr = std::malloc(bytes);
+            if (ptr && hipHostRegister(ptr, bytes, hipHostRegisterDefault)
+                    != hipSuccess) {
+                std::free(ptr);
+                ptr = nullptr;
+            }
+            break;
+        case HostMemory::mapped:
+            status = hipHostMalloc(&ptr, bytes, hipHostMallocMapped);
+            if (status == hipSuccess)
+                status = hipHostGetDevicePointer(
+                    reinterpret_cast<void**>(&_device_data), ptr, 0);
+            break;
+        case HostMemory::managed:
+        case HostMemory::managed_prefetch:
+            status = hipMallocManaged(&ptr, bytes);
+            break;
+    }
+
+    if (ptr && status != hipSuccess)
+        freeHost(kind, ptr);
+    if (!ptr || status != hipSuccess)
+        throw std::runtime_error(std::string("Failed to allocate ")
+                                 + hostMemoryName(kind) + " host memory");
+
+    _data = static_cast<char*>(ptr);
+    if (!_device_data)
+        _device_data = _data;
+}
+
+
+HostBuffer::~HostBuffer() {
+    freeHost(_kind, _data);
+}
+
+
+void copyToDevice(HostBuffer &src, void *dst) {
+
+    auto stream = copyStream(true);
+
+    if (!src.direct()) {
+        hipMemcpyAsync(dst, src.data(), src.size(),
+                       hipMemcpyHostToDevice, stream);
+        return;
+    }
+
+    if (src.kind() == HostMemory::managed_prefetch) {
+        int id;
+        hipGetDevice(&id);
+        hipMemPrefetchAsync(src.data(), src.size(), id, stream);
+    }
+
+    copyKernel(src.deviceData(), dst, src.size(), stream);
+}
+
+
+void copyToHost(const void *src, HostBuffer &dst) {
+
+    auto stream = copyStream(false);
+
+    if (!dst.direct()) {
+        hipMemcpyAsync(dst.data(), src, dst.size(),
+                       hipMemcpyDeviceToHost, stream);
+        return;
+    }
+
+    copyKernel(src, dst.deviceData(), dst.size(), stream);
+
+    if (dst.kind() == HostMemory::managed_prefetch)
+        hipMemPrefetchAsync(dst.data(), dst.size(), hipCpuDeviceId, stream);
+}
+
+#else   // Host device systems
+
+HostBuffer::HostBuffer(size_t bytes, HostMemory kind)
+    : _bytes(bytes), _kind(kind), _data(nullptr), _device_data(nullptr) {
+
+    if (bytes % sizeof(uint64_t) != 0)
+        throw std::invalid_argument("Host buffers must hold 8-byte words");
+
+    _data = static_cast<char*>(std::malloc(bytes));
+    if (!_data)
+        throw std::runtime_error("Failed to allocate host memory");
+
+    _device_data = _data;
+}
+
+
+HostBuffer::~HostBuffer() {
+    std::free(_data);
+}
+
+
+void copyToDevice(HostBuffer &src, void *dst) {
+    std::memcpy(dst, src.data(), src.size());
+}
+
+
+void copyToHost(const void *src, HostBuffer &dst) {
+    std::memcpy(dst.data(), src, dst.size());
+}
+
+#endif  // USE_HIP
+
+}   // namespace
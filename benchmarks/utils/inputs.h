@@ -0,0 +1,77 @@
+#ifndef THRUST_BENCHMARKS_INPUTS_H_
+#define THRUST_BENCHMARKS_INPUTS_H_
+
+#include <benchmark/benchmark.h>
+#include <thrust/device_vector.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include "utils/generators.h"    /* DataSpec, dataIterator, generate */
+
+
+namespace benchutils {
+
+
+/// \brief Kinds of benchmark inputs
+/// \details All kinds but materialized are functions of the index computed
+///          when an item is read, so that the input never touches memory.
+enum class InputKind : int {
+    materialized = 0,   ///< A device vector of uniform random items
+    counting,           ///< 0, 1, 2, ... from a counting_iterator
+    constant,           ///< 1 from a constant_iterator
+    random              ///< The materialized items, from dataIterator
+};
+
+///< Number of input kinds
+constexpr int n_input_kinds = 4;
+
+
+/// \brief Get the name of an input kind
+inline const char* inputKindName(InputKind kind) {
+    switch (kind) {
+        case InputKind::materialized:  return "materialized";
+        case InputKind::counting:      return "counting";
+        case InputKind::constant:      return "constant";
+        case InputKind::random:        return "random";
+    }
+    return "unknown";
+}
+
+
+/// \brief Call f with an iterator over n items of T of an input kind
+/// \details A materialized input is allocated and generated before the
+///          call, so f typically holds the timing loop and is instantiated
+///          for the iterator type of every kind.
+template <typename T, typename F>
+void withInput(InputKind kind, size_t n, F &&f) {
+    switch (kind) {
+        case InputKind::counting:
+            f(thrust::make_counting_iterator<T>(T(0)));
+            break;
+        case InputKind::constant:
+            f(thrust::make_constant_iterator<T>(T(1)));
+            break;
+        case InputKind::random:
+            f(dataIterator<T>(DataSpec(), n));
+            break;
+        default: {
+            thrust::device_vector<T> X(n);
+            generate(X, DataSpec());
+            f(X.begin());
+        }
+    }
+}
+
+
+/// \brief Arguments (million items, input kind) of benchmarks of inputs
+inline void inputArguments(benchmark::internal::Benchmark *b) {
+    for (int kind = 0; kind < n_input_kinds; ++kind)
+        for (int N = 16; N <= 256; N *= 4)
+            b->Args({N, kind});
+}
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_INPUTS_H_
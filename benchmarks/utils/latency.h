@@ -0,0 +1,166 @@
+#ifndef THRUST_BENCHMARKS_LATENCY_H_
+#define THRUST_BENCHMARKS_LATENCY_H_
+
+#include <benchmark/benchmark.h>
+#include <unistd.h>         /* isatty */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace benchutils {
+
+
+///-----------------------------------------------------------------------------
+/// \class LatencyHistogram
+/// \brief A histogram of durations with a fixed relative precision
+/// \details Durations are recorded in nanoseconds. Values below 2^(p + 1)
+///          have a bucket each, and every following power of two is split
+///          into 2^p buckets, as in HDR histograms, so that any percentile
+///          is known within 2^-p of its value. Buckets are allocated once,
+///          recording does not allocate.
+///-----------------------------------------------------------------------------
+class LatencyHistogram {
+
+public:
+
+    /// \param precision_bits p, 7 for values within 1%
+    /// \param range_bits     Values up to 2^range_bits ns, 2^44 ns ~ 5 h
+    explicit LatencyHistogram(int precision_bits = 7, int range_bits = 44)
+        : _p(precision_bits),
+          _counts(size_t(range_bits - precision_bits + 1) << precision_bits),
+          _count(0), _max(0) {
+
+        if (precision_bits < 1 || range_bits <= precision_bits)
+            throw std::invalid_argument("Invalid latency histogram range");
+    }
+
+    /// \brief Record a duration in seconds
+    void record(double seconds) {
+        auto ns = uint64_t(std::max(0.0, seconds) * 1e9);
+        auto i  = std::min(index(ns), _counts.size() - 1);
+        ++_counts[i];
+        ++_count;
+        _max = std::max(_max, ns);
+    }
+
+    uint64_t count() const { return _count; }
+
+    /// \brief Get the largest recorded duration in seconds
+    double max() const { return _max * 1e-9; }
+
+    /// \brief  Get a percentile in seconds
+    /// \param  q Percentile, in [0, 100]
+    /// \return Upper end of the bucket of the q-th percentile, at most max()
+    double percentile(double q) const {
+        if (_count == 0)
+            return 0;
+
+        auto rank = uint64_t(std::ceil(q / 100 * _count));
+        rank = std::max<uint64_t>(rank, 1);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < _counts.size(); ++i) {
+            seen += _counts[i];
+            if (seen >= rank)
+                return std::min(upper(i), _max) * 1e-9;
+        }
+        return max();
+    }
+
+    void reset() {
+        std::fill(_counts.begin(), _counts.end(), 0);
+        _count = 0;
+        _max   = 0;
+    }
+
+private:
+
+    /// \brief Get the bucket of a value
+    size_t index(uint64_t ns) const {
+        uint64_t sub = uint64_t(1) << _p;
+        if (ns < 2 * sub)
+            return size_t(ns);
+
+        int shift = 0;
+        while ((ns >> shift) >= 2 * sub)
+            ++shift;
+        return size_t(shift) * sub + size_t(ns >> shift);
+    }
+
+    /// \brief Get the largest value of a bucket
+    uint64_t upper(size_t i) const {
+        uint64_t sub = uint64_t(1) << _p;
+        if (i < 2 * sub)
+            return i;
+
+        size_t shift = i / sub - 1;
+        uint64_t low = (i - shift * sub) << shift;
+        return low + (uint64_t(1) << shift) - 1;
+    }
+
+    int                   _p;
+    std::vector<uint64_t> _counts;
+    uint64_t              _count;
+    uint64_t              _max;     ///< Largest value, ns
+};
+
+
+/// \brief Get the raw per-call durations of the running benchmark
+/// \details Filled by IterationTimer with --latency_dump, emptied when a
+///          timer is constructed, so that only the last run of a benchmark
+///          is kept, and once its runs are reported by LatencyDumpReporter.
+inline std::vector<double>& latencySamples() {
+    static std::vector<double> samples;
+    return samples;
+}
+
+
+///-----------------------------------------------------------------------------
+/// \class LatencyDumpReporter
+/// \brief A console reporter also writing raw latency samples to a CSV file
+/// \details Rows are benchmark,sample,seconds, with the run name of google
+///          benchmark, for the last run of each benchmark. Console output is
+///          colored on terminals, as with the default reporter.
+///-----------------------------------------------------------------------------
+class LatencyDumpReporter : public benchmark::ConsoleReporter {
+
+public:
+
+    /// \param path CSV file, replaced
+    explicit LatencyDumpReporter(const std::string &path)
+        : benchmark::ConsoleReporter(isatty(STDOUT_FILENO) ? OO_Color
+                                                           : OO_None),
+          _out(path, std::ios::trunc) {
+        if (!_out)
+            throw std::runtime_error("Failed to open " + path);
+        _out << "benchmark,sample,seconds\n";
+    }
+
+    void ReportRuns(const std::vector<Run> &runs) override {
+        benchmark::ConsoleReporter::ReportRuns(runs);
+
+        auto &samples = latencySamples();
+        if (!runs.empty()) {
+            auto name = runs.front().run_name.str();
+            for (size_t i = 0; i < samples.size(); ++i)
+                _out << name << "," << i << "," << samples[i] << "\n";
+            _out.flush();
+        }
+        samples.clear();
+    }
+
+private:
+
+    std::ofstream _out;
+};
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_LATENCY_H_
@@ -0,0 +1,109 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "mapped_file.h"
+#include "options.h"
+
+
+namespace benchutils {
+
+///< Granularity of touch(), the smallest page size
+static const size_t _page = 4096;
+
+
+/// \brief Make an error message ending with the reason of the last call
+static std::string systemError(const std::string &what,
+                               const std::string &path) {
+    return what + " " + path + ": " + std::strerror(errno);
+}
+
+
+MappedFile::MappedFile(const std::string &path,
+                       bool sequential, bool hugepages)
+    : _fd(-1), _data(nullptr), _size(fileSize(path)) {
+
+    if (_size == 0)
+        throw std::invalid_argument("Missing or empty file " + path);
+
+    _fd = open(path.c_str(), O_RDONLY);
+    if (_fd < 0)
+        throw std::runtime_error(systemError("Failed to open", path));
+
+    void *ptr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (ptr == MAP_FAILED) {
+        close(_fd);
+        throw std::runtime_error(systemError("Failed to map", path));
+    }
+    _data = static_cast<char*>(ptr);
+
+    // Hints only, failures are ignored
+    if (sequential)
+        madvise(_data, _size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    if (hugepages)
+        madvise(_data, _size, MADV_HUGEPAGE);
+#endif
+}
+
+
+MappedFile::~MappedFile() {
+    munmap(_data, _size);
+    close(_fd);
+}
+
+
+uint64_t MappedFile::touch() const {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < _size; i += _page)
+        sum += static_cast<const volatile char*>(_data)[i];
+    return sum;
+}
+
+
+void MappedFile::evict(const std::string &path) {
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error(systemError("Failed to open", path));
+
+    // Only clean pages are dropped
+    if (fdatasync(fd) != 0) {
+        close(fd);
+        throw std::runtime_error(systemError("Failed to sync", path));
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+
+void writeFile(const std::string &path, const void *data, size_t bytes) {
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(static_cast<const char*>(data), bytes);
+
+    if (!out)
+        throw std::runtime_error(systemError("Failed to write", path));
+}
+
+
+size_t fileSize(const std::string &path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+        return 0;
+    return size_t(info.st_size);
+}
+
+
+std::string dataPath(const std::string &name) {
+    return options().data_dir + "/" + name;
+}
+
+
+}   // namespace
@@ -0,0 +1,82 @@
+#ifndef THRUST_BENCHMARKS_MAPPED_FILE_H_
+#define THRUST_BENCHMARKS_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace benchutils {
+
+
+///-----------------------------------------------------------------------------
+/// \class MappedFile
+/// \brief A file mapped read-only into memory
+/// \details Pages are read from the file on first access. Raw typed columns
+///          are viewed in place with begin<T>() and end<T>(), so that they
+///          are copied to the device or reduced on host without reading
+///          them into a vector first.
+///-----------------------------------------------------------------------------
+class MappedFile {
+
+public:
+
+    /// \param path       File path
+    /// \param sequential Advise sequential access, for a larger read-ahead
+    /// \param hugepages  Advise transparent huge pages, where the file
+    ///                   system supports them
+    explicit MappedFile(const std::string &path,
+                        bool sequential = true, bool hugepages = true);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return _data; }
+
+    size_t size() const { return _size; }
+
+    /// \brief Get the first item of a raw column of T
+    template <typename T>
+    const T* begin() const { return reinterpret_cast<const T*>(_data); }
+
+    /// \brief Get the end of a raw column of T, trailing bytes are ignored
+    template <typename T>
+    const T* end() const { return begin<T>() + _size / sizeof(T); }
+
+    /// \brief  Read one byte per page, faulting in the whole mapping
+    /// \return Sum of the bytes read
+    uint64_t touch() const;
+
+    /// \brief Drop the pages of a file from the page cache
+    /// \details Dirty pages of a file just written are flushed first,
+    ///          since only clean pages are dropped, so that the next mapping
+    ///          reads the file from storage.
+    static void evict(const std::string &path);
+
+private:
+
+    int    _fd;
+    char  *_data;
+    size_t _size;
+};
+
+
+/// \brief Write bytes to a file, replacing it
+void writeFile(const std::string &path, const void *data, size_t bytes);
+
+
+/// \brief Get the size of a file
+/// \return Bytes, 0 if the file does not exist
+size_t fileSize(const std::string &path);
+
+
+/// \brief Get the path of an input file in options().data_dir
+std::string dataPath(const std::string &name);
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_MAPPED_FILE_H_
@@ -0,0 +1,192 @@
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "options.h"
+
+
+namespace benchutils {
+
+static Options _options;
+
+
+/// \brief Parse a boolean flag, --name or --name={true|false}
+static bool parseFlag(const char *arg, const char *name, bool &value) {
+
+    auto flag = std::string("--") + name;
+    auto len  = flag.size();
+
+    if (std::strncmp(arg, flag.c_str(), len) != 0)
+        return false;
+
+    if (arg[len] == '\0') {
+        value = true;
+        return true;
+    }
+
+    if (arg[len] != '=')
+        return false;
+
+    auto str = std::string(arg + len + 1);
+    if (str == "true" || str == "1")
+        value = true;
+    else if (str == "false" || str == "0")
+        value = false;
+    else
+        throw std::invalid_argument("Invalid value for " + flag + ": " + str);
+
+    return true;
+}
+
+
+/// \brief Get the value of an option, --name=<value>
+/// \return The value, or nullptr if the argument is another option
+static const char* optionValue(const char *arg, const char *name) {
+
+    auto flag = std::string("--") + name + "=";
+    auto len  = flag.size();
+
+    if (std::strncmp(arg, flag.c_str(), len) != 0)
+        return nullptr;
+
+    return arg + len;
+}
+
+
+/// \brief Parse a numeric option, --name=<value>
+static bool parseValue(const char *arg, const char *name, double &value) {
+
+    auto str = optionValue(arg, name);
+    if (!str)
+        return false;
+
+    try {
+        value = std::stod(str);
+    }
+    catch (const std::logic_error&) {
+        throw std::invalid_argument(std::string("Invalid value for --")
+                                    + name + ": " + str);
+    }
+
+    return true;
+}
+
+
+/// \brief Parse a string option, --name=<value>
+static bool parseValue(const char *arg, const char *name, std::string &value) {
+
+    auto str = optionValue(arg, name);
+    if (!str)
+        return false;
+
+    value = str;
+    return true;
+}
+
+
+/// \brief Parse a positive integer option, --name=<value>
+static bool parseValue(const char *arg, const char *name, int &value) {
+
+    double number;
+    if (!parseValue(arg, name, number))
+        return false;
+
+    if (number < 1 || number != int(number))
+        throw std::invalid_argument(std::string("Invalid value for --")
+                                    + name + ": " + optionValue(arg, name));
+
+    value = int(number);
+    return true;
+}
+
+
+void parseOptions(int *argc, char **argv) {
+
+    int n_args = 1;
+
+    for (int i = 1; i < *argc; ++i) {
+        if (parseFlag(argv[i], "caching_allocator", _options.caching_allocator))
+            continue;
+        if (parseValue(argv[i], "peak_bandwidth", _options.peak_bandwidth))
+            continue;
+        if (parseFlag(argv[i], "event_timing", _options.event_timing))
+            continue;
+        if (parseValue(argv[i], "timing_batch", _options.timing_batch))
+            continue;
+        if (parseValue(argv[i], "tuning_file", _options.tuning_file))
+            continue;
+        if (parseValue(argv[i], "data_dir", _options.data_dir))
+            continue;
+        if (parseFlag(argv[i], "data_cache", _options.data_cache))
+            continue;
+        if (parseValue(argv[i], "cold_start", _options.cold_start))
+            continue;
+        if (parseValue(argv[i], "cold_start_filter",
+                       _options.cold_start_filter))
+            continue;
+        if (parseFlag(argv[i], "eager_init", _options.eager_init))
+            continue;
+        if (parseFlag(argv[i], "latency", _options.latency))
+            continue;
+        if (parseValue(argv[i], "latency_dump", _options.latency_dump))
+            continue;
+        if (parseValue(argv[i], "cold_start_sample",
+                       _options.cold_start_sample))
+            continue;
+        if (parseValue(argv[i], "cold_start_t0", _options.cold_start_t0))
+            continue;
+
+        argv[n_args++] = argv[i];
+    }
+
+    if (!_options.latency_dump.empty())
+        _options.latency = true;
+
+    *argc = n_args;
+}
+
+
+const Options& options() {
+    return _options;
+}
+
+
+void printUsage() {
+    std::fputs(
+        "Suite options:\n"
+        "  [--caching_allocator[={true|false}]]\n"
+        "        cache temporary device memory of run_* functions\n"
+        "  [--peak_bandwidth=<GB/s>]\n"
+        "        peak device bandwidth for peak%, measured with a STREAM copy\n"
+        "        if not given\n"
+        "  [--event_timing[={true|false}]]\n"
+        "        time run_* functions with events on a dedicated stream instead\n"
+        "        of the wall clock and a device synchronization\n"
+        "  [--timing_batch=<K>]\n"
+        "        calls to run_* functions per pair of events, default 1\n"
+        "  [--tuning_file=<path>]\n"
+        "        host/device crossover sizes, calibrated and saved if missing,\n"
+        "        default run_benchmarks.tuning\n"
+        "  [--data_dir=<path>]\n"
+        "        directory of input files, written if missing, default .\n"
+        "  [--data_cache[={true|false}]]\n"
+        "        read generated inputs from files in --data_dir, written on\n"
+        "        first use\n"
+        "  [--cold_start=<processes>]\n"
+        "        instead of benchmarks, time the first call to run_* functions\n"
+        "        in that many fresh processes each\n"
+        "  [--cold_start_filter=<regex>]\n"
+        "        run_* functions timed by --cold_start, default all\n"
+        "  [--eager_init[={true|false}]]\n"
+        "        initialize and warm up the device in a background thread at\n"
+        "        process start\n"
+        "  [--latency[={true|false}]]\n"
+        "        record the time of every iteration and report percentiles\n"
+        "  [--latency_dump=<path>]\n"
+        "        also write every iteration time to a CSV file, implies\n"
+        "        --latency\n",
+        stdout);
+}
+
+}   // namespace
@@ -0,0 +1,61 @@
+#ifndef THRUST_BENCHMARKS_OPTIONS_H_
+#define THRUST_BENCHMARKS_OPTIONS_H_
+
+#include <string>
+
+
+/// \namespace benchutils
+/// \brief     Helper functions shared by all benchmarks.
+namespace benchutils {
+
+/// \brief Options of the benchmark suite
+struct Options {
+    bool   caching_allocator = false;   ///< Cache temporaries of run_* functions
+    double peak_bandwidth    = 0;       ///< Peak bandwidth in GB/s, 0 to measure
+    bool   event_timing      = false;   ///< Time run_* functions with events
+    int    timing_batch      = 1;       ///< Calls to run_* per pair of events
+    std::string tuning_file  = "run_benchmarks.tuning";  ///< Crossover sizes
+    std::string data_dir     = ".";     ///< Directory of input files
+    bool   data_cache        = false;   ///< Read generated inputs from files
+    int    cold_start        = 0;       ///< Processes per cold-start sample
+    std::string cold_start_filter = ".";    ///< Regex of cold-start samples
+    bool   eager_init        = false;   ///< Warm up the device at start
+    bool   latency           = false;   ///< Report latency percentiles
+    std::string latency_dump;           ///< CSV file of raw latencies
+    std::string cold_start_sample;      ///< Sample run by a child process
+    std::string cold_start_t0;          ///< Spawn time of a child process, ns
+};
+
+/// \brief Parse and remove suite options from the command line
+/// \details Remaining arguments are left for google benchmark.
+///
+///              --caching_allocator[={true|false}]
+///              --peak_bandwidth=<GB/s>
+///              --event_timing[={true|false}]
+///              --timing_batch=<K>
+///              --tuning_file=<path>
+///              --data_dir=<path>
+///              --data_cache[={true|false}]
+///              --cold_start=<processes>
+///              --cold_start_filter=<regex>
+///              --eager_init[={true|false}]
+///              --latency[={true|false}]
+///              --latency_dump=<path>
+///
+///          --cold_start_sample=<name> and --cold_start_t0=<ns> are passed
+///          by the cold-start driver to the processes it spawns.
+///
+/// \param argc Pointer to the number of arguments
+/// \param argv Arguments
+void parseOptions(int *argc, char **argv);
+
+/// \brief Get the options of the suite
+const Options& options();
+
+/// \brief Print usage of suite options
+void printUsage();
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_OPTIONS_H_
@@ -0,0 +1,52 @@
+#include <thrust/copy.h>
+#include <thrust/device_vector.h>
+#include <algorithm>
+#include <chrono>
+
+#include "gpu_utils.h"
+#include "options.h"
+#include "traffic.h"
+
+
+namespace benchutils {
+
+
+/// \brief Measure the bandwidth of a STREAM copy kernel in bytes/s
+/// \details Copies 2^25 doubles (256 MiB each way) and keeps the best of
+///          10 runs. Read and written bytes are both counted, as STREAM does.
+static double measureCopyBandwidth() {
+
+    const size_t n      = size_t(1) << 25;
+    const int    n_runs = 10;
+
+    thrust::device_vector<double> A(n, 1.0);
+    thrust::device_vector<double> B(n);
+
+    // Warm up
+    thrust::copy(A.begin(), A.end(), B.begin());
+    gpuutils::deviceSynchronize();
+
+    double best = 0;
+    for (int i = 0; i < n_runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        thrust::copy(A.begin(), A.end(), B.begin());
+        gpuutils::deviceSynchronize();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        best = std::max(best, 2. * sizeof(double) * n / elapsed.count());
+    }
+
+    return best;
+}
+
+
+double peakBandwidth() {
+    static double peak = options().peak_bandwidth > 0
+                       ? options().peak_bandwidth * 1e9
+                       : measureCopyBandwidth();
+    return peak;
+}
+
+
+}   // namespace
@@ -0,0 +1,129 @@
+#ifndef THRUST_BENCHMARKS_SEGMENTS_H_
+#define THRUST_BENCHMARKS_SEGMENTS_H_
+
+#include <thrust/device_vector.h>
+#include <thrust/fill.h>
+#include <thrust/host_vector.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/scatter.h>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+
+#include "utils/allocators.h"    /* policy, temporary_vector */
+
+
+namespace benchutils {
+
+
+/// \brief A functor for finding the segment of an item, f(i) -> s
+/// \details Segment s holds items [offsets[s], offsets[s + 1]). The segment
+///          is found by a binary search, so empty segments are skipped.
+struct segment_of {
+
+    const size_t *offsets;      ///< n_segments + 1 offsets, offsets[0] = 0
+    size_t        n_segments;
+
+    __host__ __device__
+    size_t operator()(size_t i) const {
+        // Number of segments ending at or before item i
+        size_t lo = 0, hi = n_segments;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (offsets[mid + 1] <= i)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+};
+
+
+///< Iterator over the segment ids of items
+using segment_id_iterator =
+    thrust::transform_iterator<segment_of, thrust::counting_iterator<size_t>>;
+
+
+/// \brief Get an iterator over the segment ids of items
+/// \param offsets Offsets of segments in a flat buffer, n_segments + 1 items
+inline segment_id_iterator
+make_segment_id_iterator(const thrust::device_vector<size_t> &offsets) {
+
+    if (offsets.empty())
+        throw std::invalid_argument("Segment offsets must not be empty");
+
+    segment_of op{thrust::raw_pointer_cast(offsets.data()), offsets.size() - 1};
+    return thrust::make_transform_iterator(
+                thrust::make_counting_iterator<size_t>(0), op);
+}
+
+
+/// \brief Make offsets of segments of the given lengths
+/// \return Offsets, 0 followed by the prefix sums of lengths
+inline thrust::host_vector<size_t>
+make_offsets(const thrust::host_vector<size_t> &lengths) {
+
+    thrust::host_vector<size_t> offsets(lengths.size() + 1);
+    offsets[0] = 0;
+    for (size_t s = 0; s < lengths.size(); ++s)
+        offsets[s + 1] = offsets[s] + lengths[s];
+    return offsets;
+}
+
+
+/// \brief Make random lengths of segments, uniform in [1, 2 * mean)
+inline thrust::host_vector<size_t>
+random_lengths(size_t n_segments, size_t mean, uint64_t seed = 42) {
+
+    std::mt19937_64 engine(seed);
+    std::uniform_int_distribution<size_t> length(1, 2 * mean - 1);
+
+    thrust::host_vector<size_t> lengths(n_segments);
+    for (auto &l : lengths)
+        l = length(engine);
+    return lengths;
+}
+
+
+/// \brief Sum up values segment by segment with one reduce_by_key
+/// \details reduce_by_key emits nothing for empty segments. In that case
+///          the sums are scattered to their segments and empty segments
+///          are set to zero.
+/// \param values  Values of all segments
+/// \param offsets Offsets of segments, n_segments + 1 items
+/// \param sums    Sums of segments, n_segments items
+template <typename InputIterator, typename T>
+void reduce_segments(InputIterator values,
+                     const thrust::device_vector<size_t> &offsets,
+                     thrust::device_vector<T> &sums) {
+
+    auto n_segments = offsets.size() - 1;
+    auto n_items    = size_t(offsets.back());
+    auto keys       = make_segment_id_iterator(offsets);
+
+    gpuutils::temporary_vector<size_t> segments(n_segments);
+
+    auto ends = thrust::reduce_by_key(gpuutils::policy(),
+                                      keys, keys + n_items, values,
+                                      segments.begin(), sums.begin());
+
+    auto n_nonempty = size_t(ends.first - segments.begin());
+    if (n_nonempty == n_segments)
+        return;
+
+    gpuutils::temporary_vector<T> partials(sums.begin(),
+                                           sums.begin() + n_nonempty);
+    thrust::fill(gpuutils::policy(), sums.begin(), sums.end(), T(0));
+    thrust::scatter(gpuutils::policy(), partials.begin(), partials.end(),
+                    segments.begin(), sums.begin());
+}
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_SEGMENTS_H_
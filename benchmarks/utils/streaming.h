@@ -0,0 +1,269 @@
+#ifndef THRUST_BENCHMARKS_STREAMING_H_
+#define THRUST_BENCHMARKS_STREAMING_H_
+
+#include <thrust/copy.h>
+#include <thrust/device_vector.h>
+#include <thrust/transform_reduce.h>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "utils/allocators.h"    /* policy, temporaryAllocator */
+#include "utils/gpu_utils.h"     /* pipelineStream */
+#include "utils/host_memory.h"   /* HostBuffer */
+
+
+namespace gpuutils {
+
+
+///-----------------------------------------------------------------------------
+/// \class StreamingReducer
+/// \brief Reduce host data of any size on device, chunk by chunk
+/// \details Input is split into chunks of a fixed number of items. With B
+///          buffers, up to B chunks are in flight: chunk j is staged in
+///          pinned buffer j % B and copied to device buffer j % B on
+///          pipeline stream j % B. The reduction of a chunk returns its
+///          result, so it blocks the host: the copies of the next chunks
+///          overlap with it, but staging them on host does not, and it
+///          costs about as much as the copy for pageable input. Input in
+///          pinned memory skips staging, see transformReducePinned().
+///          Partial results are combined on host in order. One buffer
+///          means no overlap. Host device systems copy and reduce chunks
+///          in turn.
+/// \tparam V Type of input items
+///-----------------------------------------------------------------------------
+template <typename V>
+class StreamingReducer {
+
+public:
+
+    /// \param chunk_items Items per chunk
+    /// \param n_buffers   Device buffers, 2 for double, 3 for triple buffering
+    StreamingReducer(size_t chunk_items, int n_buffers)
+        : _chunk_items(chunk_items) {
+
+        if (chunk_items == 0 || n_buffers < 1)
+            throw std::invalid_argument("A streaming reducer needs chunks "
+                                        "of one item or more and a buffer");
+
+        for (int b = 0; b < n_buffers; ++b) {
+            _device.emplace_back(chunk_items);
+#ifdef USE_HIP
+            // Host buffers hold whole 8-byte words
+            size_t bytes = (chunk_items * sizeof(V) + 7) / 8 * 8;
+            _staging.emplace_back(new HostBuffer(bytes, HostMemory::pinned));
+#endif
+        }
+    }
+
+    /// \brief Get the chunk size fitting a budget of device memory
+    /// \param budget    Bytes of device memory for all buffers
+    /// \param n_buffers Device buffers
+    static size_t chunkItems(size_t budget, int n_buffers) {
+        return budget / (size_t(n_buffers) * sizeof(V));
+    }
+
+    size_t chunkSize() const { return _chunk_items; }
+
+    int buffers() const { return int(_device.size()); }
+
+    /// \brief Reduce transformed items of a host range
+    /// \param first, last Random-access range of items on host
+    /// \param unary       Transformation of items, V -> T
+    /// \param init        Identity of binary, the initial value of every
+    ///                    chunk and of the result
+    /// \param binary      Associative reduction, (T, T) -> T
+    template <typename InputIterator, typename T,
+              typename UnaryFunction, typename BinaryFunction>
+    T transformReduce(InputIterator first, InputIterator last,
+                      UnaryFunction unary, T init, BinaryFunction binary) {
+
+        size_t n = std::distance(first, last);
+
+#ifdef USE_HIP
+        return reduceChunks(n, unary, init, binary,
+                            [&](size_t j, V *staging) -> const V* {
+            auto begin = first + j * _chunk_items;
+            std::copy(begin, begin + length(n, j), staging);
+            return staging;
+        });
+#else
+        size_t n_chunks = (n + _chunk_items - 1) / _chunk_items;
+        T result        = init;
+
+        for (size_t i = 0; i < n_chunks; ++i) {
+            auto begin = first + i * _chunk_items;
+            auto chunk = _device[0].begin();
+            thrust::copy(begin, begin + length(n, i), chunk);
+
+            T partial = thrust::transform_reduce(policy(),
+                                                 chunk, chunk + length(n, i),
+                                                 unary, init, binary);
+            result = binary(result, partial);
+        }
+
+        return result;
+#endif
+    }
+
+    /// \brief Reduce transformed items of pinned host memory
+    /// \details As transformReduce(), with chunks copied to device straight
+    ///          from the input, not staged. first points to pinned memory,
+    ///          e.g. a HostBuffer of HostMemory::pinned.
+    template <typename T, typename UnaryFunction, typename BinaryFunction>
+    T transformReducePinned(const V *first, const V *last,
+                            UnaryFunction unary, T init,
+                            BinaryFunction binary) {
+#ifdef USE_HIP
+        return reduceChunks(size_t(last - first), unary, init, binary,
+                            [&](size_t j, V*) -> const V* {
+            return first + j * _chunk_items;
+        });
+#else
+        return transformReduce(first, last, unary, init, binary);
+#endif
+    }
+
+private:
+
+    /// \brief Get the number of items of chunk i of n items
+    size_t length(size_t n, size_t i) const {
+        return std::min(_chunk_items, n - i * _chunk_items);
+    }
+
+#ifdef USE_HIP
+    /// \brief Reduce n items chunk by chunk, up to B chunks in flight
+    /// \param source Get chunk j in pinned memory, (j, staging buffer) ->
+    ///               address of its first item
+    template <typename T, typename UnaryFunction, typename BinaryFunction,
+              typename Source>
+    T reduceChunks(size_t n, UnaryFunction unary, T init,
+                   BinaryFunction binary, Source source) {
+
+        size_t n_chunks = (n + _chunk_items - 1) / _chunk_items;
+        size_t n_bufs   = _device.size();
+        size_t n_issued = 0;
+        T result        = init;
+
+        for (size_t i = 0; i < n_chunks; ++i) {
+            // Chunk j reuses the buffers of chunk j - B, reduced already
+            for (; n_issued < n_chunks && n_issued < i + n_bufs; ++n_issued)
+                upload(n, n_issued, source);
+
+            size_t b   = i % n_bufs;
+            auto chunk = _device[b].begin();
+            T partial  = thrust::transform_reduce(
+                             thrust::hip::par(temporaryAllocator())
+                                 .on(pipelineStream(int(b))),
+                             chunk, chunk + length(n, i),
+                             unary, init, binary);
+            result = binary(result, partial);
+        }
+
+        return result;
+    }
+
+    /// \brief Get chunk j in pinned memory and start copying it to device
+    template <typename Source>
+    void upload(size_t n, size_t j, Source &source) {
+        size_t b     = j % _device.size();
+        auto staging = reinterpret_cast<V*>(_staging[b]->data());
+
+        hipMemcpyAsync(thrust::raw_pointer_cast(_device[b].data()),
+                       source(j, staging), length(n, j) * sizeof(V),
+                       hipMemcpyHostToDevice, pipelineStream(int(b)));
+    }
+#endif
+
+    size_t _chunk_items;
+
+    ///< Device buffers, one chunk each
+    std::vector<thrust::device_vector<V>> _device;
+
+    ///< Pinned staging buffers, one per device buffer
+    std::vector<std::unique_ptr<HostBuffer>> _staging;
+};
+
+
+///-----------------------------------------------------------------------------
+/// \class StagingPool
+/// \brief Copy host data to device memory through pinned buffers
+/// \details Chunk j of a copy is staged in pinned buffer j % B and copied on
+///          pipeline stream j % B, so that staging the next chunk overlaps
+///          with the copies of the previous ones, and pageable memory or a
+///          mapped file reaches the device without an intermediate vector.
+///          Host device systems copy directly.
+/// \tparam V Type of items
+///-----------------------------------------------------------------------------
+template <typename V>
+class StagingPool {
+
+public:
+
+    /// \param chunk_items Items per pinned buffer
+    /// \param n_buffers   Pinned buffers
+    StagingPool(size_t chunk_items, int n_buffers)
+        : _chunk_items(chunk_items) {
+
+        if (chunk_items == 0 || n_buffers < 1)
+            throw std::invalid_argument("A staging pool needs chunks of one "
+                                        "item or more and a buffer");
+
+#ifdef USE_HIP
+        // Host buffers hold whole 8-byte words
+        size_t bytes = (chunk_items * sizeof(V) + 7) / 8 * 8;
+        for (int b = 0; b < n_buffers; ++b)
+            _staging.emplace_back(new HostBuffer(bytes, HostMemory::pinned));
+#endif
+    }
+
+    /// \brief Copy a host range to the front of a device vector, and wait
+    template <typename InputIterator>
+    void copy(InputIterator first, InputIterator last,
+              thrust::device_vector<V> &dst) {
+
+        size_t n = std::distance(first, last);
+        if (n > dst.size())
+            throw std::invalid_argument("Staged copy larger than its target");
+
+#ifdef USE_HIP
+        size_t n_bufs = _staging.size();
+        for (size_t j = 0; j * _chunk_items < n; ++j) {
+            size_t b      = j % n_bufs;
+            size_t offset = j * _chunk_items;
+            size_t items  = std::min(_chunk_items, n - offset);
+            auto stream   = pipelineStream(int(b));
+            auto staging  = reinterpret_cast<V*>(_staging[b]->data());
+
+            // Wait for the copy of chunk j - B out of the buffer
+            hipStreamSynchronize(stream);
+
+            std::copy(first + offset, first + offset + items, staging);
+            hipMemcpyAsync(thrust::raw_pointer_cast(dst.data()) + offset,
+                           staging, items * sizeof(V),
+                           hipMemcpyHostToDevice, stream);
+        }
+
+        for (size_t b = 0; b < n_bufs; ++b)
+            hipStreamSynchronize(pipelineStream(int(b)));
+#else
+        thrust::copy(first, last, dst.begin());
+#endif
+    }
+
+private:
+
+    size_t _chunk_items;
+
+    ///< Pinned staging buffers
+    std::vector<std::unique_ptr<HostBuffer>> _staging;
+};
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_STREAMING_H_
@@ -0,0 +1,194 @@
+#ifndef THRUST_BENCHMARKS_TIMING_H_
+#define THRUST_BENCHMARKS_TIMING_H_
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils/counters.h"     /* memory counters */
+#include "utils/gpu_utils.h"    /* EventTimer, deviceSynchronize */
+#include "utils/latency.h"      /* LatencyHistogram, latencySamples */
+#include "utils/options.h"      /* options */
+
+
+namespace benchutils {
+
+
+///-----------------------------------------------------------------------------
+/// \class IterationTimer
+/// \brief Set the manual time of benchmark iterations
+/// \details Each iteration calls a run_* function K times, K = timing_batch.
+///          The iteration time is the time per call, measured with events
+///          with --event_timing, and otherwise with the wall clock up to a
+///          device synchronization. The wall clock is always reported as
+///          the wall_time counter, so that the difference is the overhead
+///          of launches and synchronization. Memory counters start with
+///          the timer, so it is constructed once inputs are allocated, and
+///          are reported by setCounters(), after setTrafficCounters().
+///          With --latency, the time per call of every iteration goes into
+///          a histogram reported as percentiles; use --timing_batch=1 for
+///          the tail of single calls rather than of batch means.
+///          Benchmarks must be registered with UseManualTime().
+///-----------------------------------------------------------------------------
+class IterationTimer {
+
+public:
+
+    /// \param state  Benchmark state
+    /// \param batch  Calls per iteration, 1 for benchmarks restoring their
+    ///               input before each call
+    /// \param events Whether to time with events, false for calls running
+    ///               on host
+    explicit IterationTimer(benchmark::State &state,
+                            int batch = options().timing_batch,
+                            bool events = options().event_timing)
+        : _state(state), _batch(batch), _events(events), _wall_time(0) {
+        startMemoryCounters();
+
+        // Keep the samples of the last run, not of the trial runs
+        latencySamples().clear();
+    }
+
+    /// \brief Time `batch` calls to f and set the iteration time
+    template <typename F>
+    void time(F &&f) {
+
+        auto wall_start = std::chrono::steady_clock::now();
+
+        double elapsed = 0;
+        if (_events) {
+            _timer.start();
+            for (int i = 0; i < _batch; ++i)
+                f();
+            elapsed = _timer.stop();
+        }
+        else {
+            for (int i = 0; i < _batch; ++i)
+                f();
+            gpuutils::deviceSynchronize();
+        }
+
+        std::chrono::duration<double> wall_time =
+            std::chrono::steady_clock::now() - wall_start;
+
+        if (!_events)
+            elapsed = wall_time.count();
+
+        _wall_time += wall_time.count() / _batch;
+        _state.SetIterationTime(elapsed / _batch);
+
+        if (options().latency) {
+            _latency.record(elapsed / _batch);
+            if (!options().latency_dump.empty())
+                latencySamples().push_back(elapsed / _batch);
+        }
+    }
+
+    int batch() const { return _batch; }
+
+    /// \brief Report the wall time per call, memory counters, and
+    ///        percentiles with --latency
+    void setCounters() {
+        _state.counters["wall_time"] =
+            benchmark::Counter(_wall_time, benchmark::Counter::kAvgIterations);
+        setMemoryCounters(_state, memoryWindow().items);
+
+        if (options().latency) {
+            _state.counters["p50"]   = _latency.percentile(50);
+            _state.counters["p90"]   = _latency.percentile(90);
+            _state.counters["p99"]   = _latency.percentile(99);
+            _state.counters["p99.9"] = _latency.percentile(99.9);
+            _state.counters["max"]   = _latency.max();
+        }
+    }
+
+private:
+
+    benchmark::State     &_state;
+    int                   _batch;
+    bool                  _events;
+    double                _wall_time;   ///< Sum of wall time per call
+    gpuutils::EventTimer  _timer;
+    LatencyHistogram      _latency;     ///< Time per call of iterations
+};
+
+
+///-----------------------------------------------------------------------------
+/// \class PhaseTimer
+/// \brief Set the manual time of iterations made of several phases
+/// \details Each phase is timed with the wall clock up to a device
+///          synchronization and the iteration time is the sum of the
+///          phases. The time of a phase is reported as the counter
+///          <phase>_time, seconds per iteration. Memory counters start with
+///          the timer, as with IterationTimer.
+///          Benchmarks must be registered with UseManualTime().
+///-----------------------------------------------------------------------------
+class PhaseTimer {
+
+public:
+
+    explicit PhaseTimer(benchmark::State &state)
+        : _state(state), _iteration_time(0) {
+        startMemoryCounters();
+    }
+
+    /// \brief Time a phase of the current iteration
+    template <typename F>
+    void time(const std::string &phase, F &&f) {
+
+        auto start = std::chrono::steady_clock::now();
+        f();
+        gpuutils::deviceSynchronize();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        auto it = std::find_if(
+            _phases.begin(), _phases.end(),
+            [&](const Phase &p) { return p.first == phase; });
+        if (it == _phases.end())
+            _phases.emplace_back(phase, elapsed.count());
+        else
+            it->second += elapsed.count();
+
+        _iteration_time += elapsed.count();
+    }
+
+    /// \brief Set the iteration time to the sum of its phases
+    void endIteration() {
+        _state.SetIterationTime(_iteration_time);
+        _iteration_time = 0;
+    }
+
+    /// \brief Get the time of a phase summed over iterations, 0 if unknown
+    double phaseTime(const std::string &phase) const {
+        for (auto &p : _phases)
+            if (p.first == phase)
+                return p.second;
+        return 0;
+    }
+
+    /// \brief Report the time of each phase and memory counters
+    void setCounters() {
+        for (auto &p : _phases)
+            _state.counters[p.first + "_time"] = benchmark::Counter(
+                p.second, benchmark::Counter::kAvgIterations);
+        setMemoryCounters(_state, memoryWindow().items);
+    }
+
+private:
+
+    using Phase = std::pair<std::string, double>;
+
+    benchmark::State    &_state;
+    std::vector<Phase>   _phases;           ///< Phases in order of first use
+    double               _iteration_time;   ///< Time of the current iteration
+};
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_TIMING_H_
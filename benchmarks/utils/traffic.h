@@ -0,0 +1,75 @@
+#ifndef THRUST_BENCHMARKS_TRAFFIC_H_
+#define THRUST_BENCHMARKS_TRAFFIC_H_
+
+#include <cstddef>
+
+
+namespace benchutils {
+
+
+///-----------------------------------------------------------------------------
+/// \struct Traffic
+/// \brief  Memory traffic and arithmetic of one call to a run_* function
+/// \details Bytes are those moved by the thrust calls as written, including
+///          temporaries, so that the achieved bandwidth can be compared
+///          with the peak. FLOPs count additions, multiplications and
+///          divisions; comparisons are free. Copies between host and device
+///          are counted apart, once, as bytes crossing the link.
+///-----------------------------------------------------------------------------
+struct Traffic {
+
+    double read_bytes  = 0;     ///< Bytes read from device memory
+    double write_bytes = 0;     ///< Bytes written to device memory
+    double flops       = 0;     ///< Floating-point operations
+    double n_items     = 0;     ///< Items of the largest pass
+    double transfers   = 0;     ///< Bytes copied between host and device
+
+    /// \brief Traffic of a pass over n items of `size` bytes
+    /// \param reads  Items read per index
+    /// \param writes Items written per index
+    /// \param flops  FLOPs per index
+    static Traffic items(size_t n, size_t size,
+                         double reads, double writes, double flops = 0) {
+        return Traffic{double(n) * size * reads,
+                       double(n) * size * writes,
+                       double(n) * flops,
+                       double(n)};
+    }
+
+    /// \brief Traffic of a copy of n items of `size` bytes between host
+    ///        and device, in one direction
+    static Traffic transfer(size_t n, size_t size) {
+        return Traffic{0, 0, 0, double(n), double(n) * size};
+    }
+
+    double bytes() const { return read_bytes + write_bytes; }
+
+    /// \brief Arithmetic intensity, FLOPs per byte
+    double intensity() const {
+        return bytes() > 0 ? flops / bytes() : 0;
+    }
+
+    Traffic& operator+=(const Traffic &other) {
+        read_bytes  += other.read_bytes;
+        write_bytes += other.write_bytes;
+        flops       += other.flops;
+        n_items      = n_items > other.n_items ? n_items : other.n_items;
+        transfers   += other.transfers;
+        return *this;
+    }
+
+    Traffic operator+(const Traffic &other) const {
+        return Traffic(*this) += other;
+    }
+};
+
+
+/// \brief Get the peak device bandwidth in bytes/s
+/// \details Measured once with a STREAM copy unless --peak_bandwidth is given.
+double peakBandwidth();
+
+
+}   // namespace
+
+
+#endif  // THRUST_BENCHMARKS_TRAFFIC_H_
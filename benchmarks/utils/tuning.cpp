@@ -0,0 +1,108 @@
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "dispatch.h"
+#include "options.h"
+
+
+namespace benchutils {
+
+static const size_t _never = std::numeric_limits<size_t>::max();
+
+static std::map<std::string, size_t> _crossovers;
+static bool       _loaded = false;
+static std::mutex _mutex;
+
+
+/// \brief Read crossovers, lines of `<name> <size|never>`
+static void loadTuning() {
+
+    std::ifstream in(options().tuning_file);
+    std::string line;
+
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream fields(line);
+        std::string name, size;
+        if (!(fields >> name >> size))
+            throw std::invalid_argument("Invalid line in "
+                                        + options().tuning_file + ": " + line);
+
+        _crossovers[name] = size == "never" ? _never : std::stoull(size);
+    }
+}
+
+
+/// \brief Write all crossovers
+static void saveTuning() {
+
+    std::ofstream out(options().tuning_file);
+    if (!out)
+        throw std::runtime_error("Failed to write " + options().tuning_file);
+
+    out << "# Host/device crossover sizes, items\n";
+    for (auto &p : _crossovers) {
+        out << p.first << ' ';
+        if (p.second == _never)
+            out << "never\n";
+        else
+            out << p.second << '\n';
+    }
+}
+
+
+/// \brief Time both targets and find the crossover
+/// \details The crossover is the smallest sampled size from which the
+///          device stays faster, so that noise at a single size does not
+///          send large calls to the host.
+static size_t calibrate(const std::string &name,
+                        const std::function<double(size_t, Target)> &time) {
+
+    std::fprintf(stderr, "Calibrating the crossover of %s\n", name.c_str());
+
+    std::vector<size_t> sizes;
+    for (size_t n = size_t(1) << 10; n <= size_t(4) << 20; n <<= 1)
+        sizes.push_back(n);
+
+    size_t crossover = _never;
+    for (auto it = sizes.rbegin(); it != sizes.rend(); ++it) {
+        if (time(*it, Target::device) >= time(*it, Target::host))
+            break;
+        crossover = *it;
+    }
+
+    return crossover;
+}
+
+
+size_t crossover(const std::string &name,
+                 const std::function<double(size_t, Target)> &time) {
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_loaded) {
+        loadTuning();
+        _loaded = true;
+    }
+
+    auto it = _crossovers.find(name);
+    if (it != _crossovers.end())
+        return it->second;
+
+    auto size = calibrate(name, time);
+    _crossovers[name] = size;
+    saveTuning();
+
+    return size;
+}
+
+
+}   // namespace
@@ -0,0 +1,91 @@
+# ==============================================================================
+#
+#   Select the Thrust device system and find necessary packages.
+#
+#   setup_backend()
+#
+#   Variables:
+#       DEVICE_SYSTEM       HIP (default), CPP, OMP or TBB
+#       HOST_SYSTEM         CPP (default), OMP or TBB, used by thrust::host
+#   Packages:
+#       HIP, rocprim, rocthrust (DEVICE_SYSTEM = HIP)
+#       Thrust                  (DEVICE_SYSTEM = CPP, OMP, TBB)
+#   Targets:
+#       thrust_backend          (DEVICE_SYSTEM = CPP, OMP, TBB)
+#       thrust_host             (DEVICE_SYSTEM = HIP)
+#
+#   backend_add_library(<name> <sources...>)
+#   backend_add_executable(<name> <sources...>)
+#
+#       Add a library or an executable compiled for the selected backend.
+#       HIP sources are compiled by hipcc, others by the host compiler.
+#
+# ==============================================================================
+include(SetupHIP)
+
+set(DEVICE_SYSTEM "HIP" CACHE STRING "Thrust device system: HIP, CPP, OMP or TBB")
+set_property(CACHE DEVICE_SYSTEM PROPERTY STRINGS HIP CPP OMP TBB)
+
+set(HOST_SYSTEM "CPP" CACHE STRING "Thrust host system: CPP, OMP or TBB")
+set_property(CACHE HOST_SYSTEM PROPERTY STRINGS CPP OMP TBB)
+
+macro(setup_backend)
+
+    if(NOT HOST_SYSTEM MATCHES "^(CPP|OMP|TBB)$")
+        message(FATAL_ERROR "Unsupported HOST_SYSTEM: ${HOST_SYSTEM}")
+    endif()
+
+    if(DEVICE_SYSTEM STREQUAL "HIP")
+        setup_hip()
+
+        # rocThrust selects the host system with a macro
+        add_library(thrust_host INTERFACE)
+        target_compile_definitions(thrust_host INTERFACE
+            THRUST_HOST_SYSTEM=THRUST_HOST_SYSTEM_${HOST_SYSTEM})
+        if(HOST_SYSTEM STREQUAL "OMP")
+            find_package(OpenMP REQUIRED)
+            list(APPEND HIP_HIPCC_FLAGS ${OpenMP_CXX_FLAGS})
+            target_link_libraries(thrust_host INTERFACE OpenMP::OpenMP_CXX)
+        elseif(HOST_SYSTEM STREQUAL "TBB")
+            find_package(TBB REQUIRED)
+            target_link_libraries(thrust_host INTERFACE TBB::tbb)
+        endif()
+    elseif(DEVICE_SYSTEM MATCHES "^(CPP|OMP|TBB)$")
+        # Host device systems come from the upstream Thrust package, which
+        # brings in OpenMP or TBB as needed.
+        find_package(Thrust REQUIRED CONFIG)
+        thrust_create_target(thrust_backend
+                             HOST ${HOST_SYSTEM} DEVICE ${DEVICE_SYSTEM})
+    else()
+        message(FATAL_ERROR "Unsupported DEVICE_SYSTEM: ${DEVICE_SYSTEM}")
+    endif()
+
+    message(STATUS "Thrust device system: ${DEVICE_SYSTEM}")
+    message(STATUS "Thrust host system: ${HOST_SYSTEM}")
+
+endmacro()
+
+
+function(backend_add_library name)
+
+    if(DEVICE_SYSTEM STREQUAL "HIP")
+        set_source_files_properties(${ARGN} PROPERTIES HIP_SOURCE_PROPERTY_FORMAT 1)
+        hip_add_library(${name} ${ARGN})
+    else()
+        # Object libraries keep static benchmark registrations from being
+        # dropped by the linker.
+        add_library(${name} OBJECT ${ARGN})
+    endif()
+
+endfunction()
+
+
+function(backend_add_executable name)
+
+    if(DEVICE_SYSTEM STREQUAL "HIP")
+        hip_add_executable(${name} ${ARGN})
+    else()
+        add_executable(${name} ${ARGN})
+    endif()
+
+endfunction()